@@ -0,0 +1,160 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for batchContains, which checks a batch
+of int keys against a hash table 8 keys at a time with AVX2, for
+HashTable<int> and the tables of BiMap<int,int>.
+*/
+#ifndef BATCH_PROBE_H
+#define BATCH_PROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <functional>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_PROBE_X86
+#endif
+using namespace std;
+
+// Batch membership check for int keys
+//
+// The slots are those of a table with sentinels: slot i holds its key
+// Stride bytes after slot i - 1, and EMPTY and DELETED slots hold the
+// sentinel keys. A key k >= 0 has home slot k % capacity, as
+// std::hash<int> is the identity.
+//
+// With AVX2 (checked at run time) batchContains( ) takes 8 keys at a
+// time: it reduces them to their home slots with vector arithmetic,
+// gathers the 8 slots in one instruction and compares them with the
+// keys. A lane whose home slot holds its key is a hit, and one whose
+// home slot is EMPTY is a miss. The rest (collisions, DELETED slots,
+// negative keys and sentinels) go to probe( ), the table's own
+// contains( ). Without AVX2 every key goes to probe( ).
+//
+// ******************PUBLIC OPERATIONS*********************
+// bool batchKernelAvailable( ) --> Return true if the AVX2 kernel runs
+// void batchContains<Stride>( slots, capacity, emptyKey, deletedKey,
+//                             keys, n, found, probe )
+//                            --> Set found[i] for each of the n keys
+
+/**
+ * Check once whether this CPU runs the AVX2 kernel, and whether
+ * std::hash<int> is the identity, as the kernel assumes.
+ *
+ * @return True if batchContains( ) uses the kernel.
+ */
+inline bool batchKernelAvailable()
+{
+#ifdef BATCH_PROBE_X86
+    static const bool available = []
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") &&
+               hash<int>()(123456789) == 123456789 && hash<int>()(1) == 1;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+#ifdef BATCH_PROBE_X86
+/**
+ * The AVX2 kernel of batchContains( ). It stops before the last
+ * n % 8 keys.
+ *
+ * @return The number of keys done.
+ */
+template <int Stride, typename Probe>
+__attribute__((target("avx2"))) size_t
+batchContainsAvx2(const int *slots, size_t capacity, int emptyKey, int deletedKey,
+                  const int *keys, size_t n, bool *found, Probe &probe)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i cap = _mm256_set1_epi32((int)capacity);
+    const __m256i lastSlot = _mm256_set1_epi32((int)capacity - 1);
+    const __m256i empty = _mm256_set1_epi32(emptyKey);
+    const __m256i deleted = _mm256_set1_epi32(deletedKey);
+    const __m256d inverse = _mm256_set1_pd(1.0 / (double)capacity);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i k = _mm256_loadu_si256((const __m256i *)(keys + i));
+
+        // Negative keys hash past 2^31, and sentinels live in side
+        // slots; leave those lanes to probe( )
+        __m256i other = _mm256_or_si256(
+            _mm256_cmpgt_epi32(zero, k),
+            _mm256_or_si256(_mm256_cmpeq_epi32(k, empty), _mm256_cmpeq_epi32(k, deleted)));
+
+        // k % capacity: the quotient from the double product is off by
+        // at most one, which the two corrections below take out
+        __m128i qLow = _mm256_cvttpd_epi32(
+            _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(k)), inverse));
+        __m128i qHigh = _mm256_cvttpd_epi32(
+            _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(k, 1)), inverse));
+        __m256i q = _mm256_inserti128_si256(_mm256_castsi128_si256(qLow), qHigh, 1);
+        __m256i home = _mm256_sub_epi32(k, _mm256_mullo_epi32(q, cap));
+        home = _mm256_add_epi32(home, _mm256_and_si256(_mm256_cmpgt_epi32(zero, home), cap));
+        home = _mm256_sub_epi32(home, _mm256_and_si256(_mm256_cmpgt_epi32(home, lastSlot), cap));
+        home = _mm256_andnot_si256(other, home); // Keep every load in the array
+
+        __m256i slot = _mm256_i32gather_epi32(slots, home, Stride);
+        unsigned hits = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_andnot_si256(other, _mm256_cmpeq_epi32(slot, k))));
+        unsigned misses = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_andnot_si256(other, _mm256_cmpeq_epi32(slot, empty))));
+
+        for (int lane = 0; lane < 8; lane++)
+            found[i + lane] = (hits >> lane) & 1;
+
+        // Probe the lanes the home slot did not settle
+        for (unsigned rest = ~(hits | misses) & 0xFF; rest != 0; rest &= rest - 1)
+        {
+            size_t j = i + __builtin_ctz(rest);
+            found[j] = probe(keys[j]);
+        }
+    }
+    return i;
+}
+#endif
+
+/**
+ * Check a batch of int keys against the slots of a table.
+ *
+ * @param slots The key of slot 0; Stride (4 or 8) is the bytes per slot.
+ * @param capacity The number of slots.
+ * @param emptyKey The key of an EMPTY slot.
+ * @param deletedKey The key of a DELETED slot.
+ * @param keys The keys to check.
+ * @param n The number of keys.
+ * @param found Set found[i] to true iff keys[i] is in the table.
+ * @param probe The table's contains( ), for the keys the kernel leaves.
+ */
+template <int Stride, typename Probe>
+void batchContains(const int *slots, size_t capacity, int emptyKey, int deletedKey,
+                   const int *keys, size_t n, bool *found, Probe probe)
+{
+    static_assert(Stride == 4 || Stride == 8, "A slot must be 4 or 8 bytes");
+
+    size_t done = 0;
+#ifdef BATCH_PROBE_X86
+    if (capacity > 0 && capacity <= INT_MAX && batchKernelAvailable())
+        done = batchContainsAvx2<Stride>(slots, capacity, emptyKey, deletedKey,
+                                         keys, n, found, probe);
+#endif
+    for (size_t i = done; i < n; i++)
+        found[i] = probe(keys[i]);
+}
+
+#endif
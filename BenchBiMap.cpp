@@ -0,0 +1,232 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file benchmarks BiMap lookups. It compares the plain probe
+path with the front caches under a Zipf(0.99) key distribution,
+slot arrays on normal pages with huge pages under uniform lookups,
+tiny maps with and without their pairs inline, and batch containsKeys
+with one containsKey per key.
+*/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include "BiMap.h"
+#include "MmapAllocator.h"
+using namespace std;
+
+const int PAIRS = 1 << 20;       // Number of pairs in the map
+const int LOOKUPS = 1 << 24;     // Number of lookups per run
+const double ZIPF_S = 0.99;      // Zipf exponent
+const int BIG_PAIRS = 1 << 23;   // Number of pairs in the huge page map
+const int TINY_MAPS = 1 << 18;   // Number of tiny maps
+const int TINY_PAIRS = 6;        // Number of pairs in a tiny map
+
+// BiMap traits that allocate both slot arrays with Alloc
+template <template <typename> class Alloc>
+struct AllocTraits : BiMapTraits<int, int>
+{
+    struct KeyTableTraits : HashTableTraits<int>
+    {
+        template <typename T>
+        using Allocator = Alloc<T>;
+    };
+    typedef KeyTableTraits ValTableTraits;
+};
+
+template <typename T>
+using HugePageAllocator = MmapAllocator<T>;
+
+template <typename T>
+using PrefaultedHugePageAllocator = MmapAllocator<T, true>;
+
+// Draw keys in [0, n) from a Zipf(s) distribution, key 0 the most likely.
+// The ranks are shuffled onto the keys so hot keys are spread out.
+vector<int> zipfKeys(int n, double s, int count, unsigned seed)
+{
+    vector<double> cdf(n);
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        cdf[i] = (sum += 1.0 / pow(i + 1, s));
+
+    vector<int> keyOfRank(n);
+    for (int i = 0; i < n; i++)
+        keyOfRank[i] = i;
+    mt19937 gen(seed);
+    shuffle(keyOfRank.begin(), keyOfRank.end(), gen);
+
+    uniform_real_distribution<double> uniform(0, sum);
+    vector<int> keys(count);
+    for (auto &k : keys)
+        k = keyOfRank[lower_bound(cdf.begin(), cdf.end(), uniform(gen)) - cdf.begin()];
+    return keys;
+}
+
+// Time getVal over the keys; return nanoseconds per lookup.
+// If chained, each key depends on the previous value (which is
+// below 2^30, so the shift is 0), so the lookups cannot overlap
+// and the time is the latency of one lookup rather than the
+// throughput of many in flight.
+template <typename Map>
+double timeLookups(const Map &map, const vector<int> &keys, bool chained)
+{
+    long long checksum = 0;
+    int last = 0;
+    auto start = chrono::steady_clock::now();
+    for (int k : keys)
+    {
+        last = map.getVal(chained ? k ^ (last >> 30) : k);
+        checksum += last;
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    if (checksum == 42) // Keep the loop from being optimized away
+        cout << "";
+    return ns / keys.size();
+}
+
+// Build a map of BIG_PAIRS pairs with the allocator, then time
+// uniform random getVal lookups on it
+template <template <typename> class Alloc>
+void benchAllocator(const char *name, const vector<int> &keys)
+{
+    auto start = chrono::steady_clock::now();
+    BiMap<int, int, AllocTraits<Alloc>> map(4 * (size_t)BIG_PAIRS);
+    double allocMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    for (int i = 0; i < BIG_PAIRS; i++)
+        map.insert(i, BIG_PAIRS - i);
+
+    cout << "  " << name << setw(8) << allocMs << " ms"
+         << setw(10) << timeLookups(map, keys, false)
+         << setw(12) << timeLookups(map, keys, true) << endl;
+}
+
+// Compare the front caches with the plain probe path
+void benchFrontCache()
+{
+    cout << "BiMap<int,int> with " << PAIRS << " pairs, " << LOOKUPS
+         << " getVal lookups, Zipf(" << ZIPF_S << ")" << endl;
+
+    BiMap<int, int> map;
+    for (int i = 0; i < PAIRS; i++)
+        map.insert(i, PAIRS - i);
+    vector<int> keys = zipfKeys(PAIRS, ZIPF_S, LOOKUPS, 225);
+
+    cout << "                            independent   chained (ns/lookup)" << endl;
+    for (int slots : {0, 1024, 16384, 262144})
+    {
+        map.setFrontCacheSize(slots);
+        timeLookups(map, keys, false); // Warm up the cache
+        if (slots == 0)
+            cout << "  plain probe:             ";
+        else
+            cout << "  front cache " << setw(6) << slots << " slots: ";
+        cout << setw(8) << timeLookups(map, keys, false)
+             << "    " << setw(8) << timeLookups(map, keys, true) << endl;
+    }
+}
+
+// Compare slot arrays on normal pages with huge pages
+void benchHugePages()
+{
+    cout << "BiMap<int,int> with " << BIG_PAIRS << " pairs in "
+         << 4 * BIG_PAIRS << "-slot tables, " << LOOKUPS
+         << " uniform getVal lookups" << endl;
+
+    mt19937 gen(225);
+    uniform_int_distribution<int> uniform(0, BIG_PAIRS - 1);
+    vector<int> keys(LOOKUPS);
+    for (auto &k : keys)
+        k = uniform(gen);
+
+    cout << "                          allocate  independent   chained (ns/lookup)" << endl;
+    benchAllocator<allocator>("std::allocator:      ", keys);
+    benchAllocator<HugePageAllocator>("huge pages:          ", keys);
+    benchAllocator<PrefaultedHugePageAllocator>("huge pages, prefault:", keys);
+}
+
+// Build TINY_MAPS maps of TINY_PAIRS pairs, look up every pair in
+// each, then destroy them; print the time per map
+template <typename Traits>
+void benchTinyMaps(const char *name)
+{
+    long long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    {
+        vector<BiMap<int, int, Traits>> maps(TINY_MAPS);
+        for (auto &map : maps)
+            for (int i = 0; i < TINY_PAIRS; i++)
+                map.insert(i, 10 * i);
+        for (auto &map : maps)
+            for (int i = 0; i < TINY_PAIRS; i++)
+                checksum += map.getVal(i) + map.getKey(10 * i);
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    if (checksum == 42) // Keep the loops from being optimized away
+        cout << "";
+    cout << "  " << name << setw(10) << ns / TINY_MAPS << " ns/map" << endl;
+}
+
+// Compare tiny maps in their tables with tiny maps kept inline
+void benchSmallMaps()
+{
+    cout << TINY_MAPS << " BiMap<int,int> of " << TINY_PAIRS
+         << " pairs: build, look up every pair both ways, destroy" << endl;
+    benchTinyMaps<BiMapTraits<int, int>>("tables:          ");
+    benchTinyMaps<SmallBiMapTraits<int, int>>("inline (N = 8):  ");
+}
+
+// Compare containsKeys over a batch with containsKey per key, for
+// uniform keys of which half are in the map
+void benchBatch()
+{
+    cout << "BiMap<int,int> with " << PAIRS << " pairs, " << LOOKUPS
+         << " uniform membership checks, half of them hits" << endl;
+
+    BiMap<int, int> map;
+    for (int i = 0; i < PAIRS; i++)
+        map.insert(2 * i, i);
+    mt19937 gen(225);
+    uniform_int_distribution<int> uniform(0, 2 * PAIRS - 1);
+    vector<int> keys(LOOKUPS);
+    for (auto &k : keys)
+        k = uniform(gen);
+    unique_ptr<bool[]> found(new bool[LOOKUPS]);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < LOOKUPS; i++)
+        found[i] = map.containsKey(keys[i]);
+    double oneNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    long long hits = count(found.get(), found.get() + LOOKUPS, true);
+
+    start = chrono::steady_clock::now();
+    map.containsKeys(keys.data(), LOOKUPS, found.get());
+    double batchNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    if (count(found.get(), found.get() + LOOKUPS, true) != hits)
+        cout << "  containsKeys and containsKey disagree" << endl;
+
+    cout << "  containsKey per key: " << setw(8) << oneNs / LOOKUPS << " ns/key" << endl
+         << "  containsKeys" << (batchKernelAvailable() ? " (AVX2): " : " (scalar):")
+         << setw(8) << batchNs / LOOKUPS << " ns/key" << endl;
+}
+
+int main()
+{
+    benchFrontCache();
+    benchHugePages();
+    benchSmallMaps();
+    benchBatch();
+    return 0;
+}
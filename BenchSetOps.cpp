@@ -0,0 +1,58 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file benchmarks the HashTable set operations on two large sets
+of ints, on 1 thread and on up to one thread per core.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include "QuadraticProbing.h"
+using namespace std;
+
+const int SET_SIZE = 1 << 24; // Number of objs in each set
+
+// Time f( ) in milliseconds
+template <typename Op>
+double timeMs(Op f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    // Half of each set is in the other
+    HashTable<int> a, b;
+    for (int i = 0; i < SET_SIZE; i++)
+    {
+        a.insert(2 * i);
+        b.insert(2 * i + SET_SIZE);
+    }
+
+    cout << "Two HashTable<int> sets of " << SET_SIZE << " objs, half shared ("
+         << thread::hardware_concurrency() << " cores)" << endl;
+    cout << "  threads  intersect      unite   subtract   isSubset (ms)" << endl;
+    size_t checksum = 0;
+    for (unsigned threads = 1; threads <= max(1u, thread::hardware_concurrency()); threads *= 2)
+    {
+        cout << setw(9) << threads
+             << setw(11) << timeMs([&] { checksum += a.intersect(b, threads).getSize(); })
+             << setw(11) << timeMs([&] { checksum += a.unite(b, threads).getSize(); })
+             << setw(11) << timeMs([&] { checksum += a.subtract(b, threads).getSize(); })
+             << setw(11) << timeMs([&] { checksum += a.isSubset(b, threads); }) << endl;
+    }
+
+    if (checksum == 42) // Keep the results from being optimized away
+        cout << "";
+    return 0;
+}
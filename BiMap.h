@@ -19,30 +19,135 @@ and to remove a pair given a key or value.
 #define BI_MAP_H
 
 #include "QuadraticProbingBiMap.h" // Required for HashTable
+#include "BiMapInstrumentation.h"
+#include "FrontCache.h"
+#include "BiMapSnapshot.h"
+#include "InlinePairArray.h"
+#include "BiMapTransaction.h"
 using namespace std;
 
+/**
+ * Default traits for a BiMap from KeyType to ValType.
+ *
+ * To configure a map, derive from this struct and override a typedef,
+ * e.g. to time every operation:
+ *
+ *   struct TimedTraits : BiMapTraits<int, int>
+ *   {
+ *       typedef LatencyInstrumentation Instrumentation;
+ *   };
+ *
+ * or to give the key table custom sentinels:
+ *
+ *   struct IdTraits : BiMapTraits<int, int>
+ *   {
+ *       typedef HashTableTraits<int> ValTableTraits;
+ *       struct KeyTableTraits : HashTableTraits<int>
+ *       {
+ *           typedef FixedSentinels<int, -1, -2> Sentinels;
+ *       };
+ *   };
+ */
+template <typename KeyType, typename ValType>
+struct BiMapTraits
+{
+    typedef HashTableTraits<KeyType> KeyTableTraits; // Traits of keyTable
+    typedef HashTableTraits<ValType> ValTableTraits; // Traits of valTable
+    typedef NoInstrumentation Instrumentation;       // What gets recorded
+    typedef size_t SizeType;                         // Type of pair counts
+    static const size_t InlinePairs = 0;             // Pairs kept inline
+};
+
+/**
+ * Traits for a small BiMap, with 32-bit sizes and positions in the
+ * map and both tables (see CompactHashTableTraits).
+ */
+template <typename KeyType, typename ValType>
+struct CompactBiMapTraits : BiMapTraits<KeyType, ValType>
+{
+    typedef CompactHashTableTraits<KeyType> KeyTableTraits;
+    typedef CompactHashTableTraits<ValType> ValTableTraits;
+    typedef uint32_t SizeType;
+};
+
+/**
+ * Traits for a small BiMap, which keeps up to N pairs inline in the
+ * map object and creates its tables only when it outgrows them.
+ */
+template <typename KeyType, typename ValType, size_t N = 8>
+struct SmallBiMapTraits : BiMapTraits<KeyType, ValType>
+{
+    static const size_t InlinePairs = N;
+};
+
+/**
+ * Traits for a BiMap whose tables keep their slots in copy-on-write
+ * pages, so snapshot( ) costs O(1) (see CowHashTableTraits).
+ */
+template <typename KeyType, typename ValType>
+struct CowBiMapTraits : BiMapTraits<KeyType, ValType>
+{
+    typedef CowHashTableTraits<KeyType> KeyTableTraits;
+    typedef CowHashTableTraits<ValType> ValTableTraits;
+};
+
 // Bijective Map class
 //
 // CONSTRUCTION: Implemented with two hash tables with Quaddratic Probing.
+//               Traits configures the two tables (see BiMapTraits).
+//               With maxPairs > 0 the map is a bounded cache: inserting
+//               into a full map evicts a pair chosen by CLOCK.
+//               With Traits::InlinePairs > 0 (see SmallBiMapTraits) an
+//               unbounded map starts in small mode: its pairs are kept
+//               inline and found by a linear scan, and the tables are
+//               not allocated until it outgrows the inline pairs.
 //
 // ******************PUBLIC OPERATIONS*********************
-// void makeEmpty()           --> Remove all pairs
-// int getSize() const        --> Return the current number of pairs
+// void makeEmpty()           --> Remove all pairs, shrinking the tables
+//                                back to their initial size
+// size_t getSize() const     --> Return the current number of pairs
 // bool insert(x, y)          --> Insert pair <x,y>, provided x is not 
 //                                the key of a current pair and y is not 
 //                                the value of a current pair.
 //                                Return true iff <x,y> was inserted.
 // bool containsKey(x)        --> Return true if x is the key of a current pair
 // bool containsVal(x)        --> Return true if x is the value of a current pair
+// void containsKeys(xs, n, found) --> Set found[i] to containsKey(xs[i])
+// void containsVals(xs, n, found) --> Set found[i] to containsVal(xs[i])
 // bool removeKey(x)          --> Remove the pair with key x if it exists
 // bool removeVal(x)          --> Remove the pair with value x if it exists
+// bool apply(tx, conflicts)  --> Apply all of transaction tx, or none of
+//                                it and list its conflicting entries
 // const & ValType getVal(x)  --> Return the value associated with key x
 // const & KeyType getKey(x)  --> Return the key associated with value x
+// void forEachPair(f)        --> Call f(x, y) for every pair <x,y>
+// MemoryUsage memoryUsage()  --> Return the memory used by both tables
+// void setShrinkThreshold(f) --> Shrink the tables when their live load
+//                                falls below f (default 0.125)
+// void shrinkToFit()         --> Shrink the tables to fit the pairs, or
+//                                move the pairs back inline if they fit;
+//                                a bounded map keeps its tables
+// bool isSmall() const       --> Return true if the pairs are inline
+// size_t getMaxPairs() const --> Return the pair limit (0 if unbounded)
+// size_t getHits() const     --> Return the getVal/getKey hits (bounded)
+// size_t getMisses() const   --> Return the getVal/getKey misses (bounded)
+// size_t getEvictions() const --> Return the number of evicted pairs
+// void setFrontCacheSize(n)  --> Cache up to about n recent lookups per
+//                                direction in front of the tables; 0 (the
+//                                default) turns the caches off
+// getInstrumentation()       --> Return the instrumentation policy, e.g.
+//                                the latency histograms and rehash hook
+// BiMapSnapshot snapshot()   --> Return a read-only view of the pairs as
+//                                they are now
 
-template <typename KeyType, typename ValType>
+template <typename KeyType, typename ValType,
+          typename Traits = BiMapTraits<KeyType, ValType>>
 class BiMap
 {
 public:
+    typedef typename Traits::Instrumentation Instrumentation;
+    typedef BiMapTransaction<KeyType, ValType> Transaction;
+
     /**
      * Constructor
      *
@@ -50,12 +155,29 @@ public:
      * greater than or equal to the specified size. If no size is provided,
      * the default size is 101.
      *
+     * If maxPairs is positive, the map holds at most maxPairs pairs and
+     * evicts one when full. Its tables are sized up front to at least
+     * 4 * maxPairs, so they never grow. An insert reuses a DELETED
+     * entry on its probe path, but an evicted pair's entry is seldom on
+     * the path of the next key, so each table still rebuilds at the
+     * same size about once every maxPairs evictions: a pause of
+     * O(maxPairs), or O(1) amortized over the evictions.
+     *
+     * A map in small mode allocates no tables, and ignores size: its
+     * tables start at 4 * Traits::InlinePairs slots.
+     *
      * @param size The initial size of the hash tables (default: 101).
+     * @param maxPairs The maximum number of pairs (default: 0, unbounded).
+     * @throws std::length_error If the tables would be too large for
+     *         the SizeType of their traits.
      */
-    explicit BiMap(int size = 101) : keyTable(size),
-                                     valTable(size)
+    explicit BiMap(size_t size = 101, size_t maxPairs = 0)
+        : keyTable(hasSmallMode(maxPairs) ? 0 : tableSize(size, maxPairs)),
+          valTable(hasSmallMode(maxPairs) ? 0 : tableSize(size, maxPairs)),
+          maxPairs((SizeType)maxPairs), hits(0), misses(0), evictions(0)
     {
         makeEmpty();
+        keyTable.setClockTracking(maxPairs > 0);
     }
 
     /**
@@ -66,6 +188,10 @@ public:
         currentSize = 0;
         keyTable.makeEmpty();
         valTable.makeEmpty();
+        keyCache.clear();
+        valCache.clear();
+        small.clear();
+        small.setActive(hasSmallMode(maxPairs));
     }
 
     /**
@@ -73,7 +199,7 @@ public:
      *
      * @return The number of pairs in the map.
      */
-    int getSize() const { return currentSize; }
+    size_t getSize() const { return currentSize; }
 
     /**
      * Insert a new key-value pair into the map.
@@ -87,11 +213,30 @@ public:
      */
     bool insert(const KeyType &x, const ValType &y)
     {
+        typename Instrumentation::Scope scope(instrumentation, OP_INSERT);
+
+        if (small.isActive())
+        {
+            if (small.findKey(x) != INLINE_PAIRS || small.findVal(y) != INLINE_PAIRS)
+                return false;
+            if (!small.isFull())
+            {
+                small.add(x, y);
+                currentSize++;
+                return true;
+            }
+            moveToTables();
+        }
+
         if (keyTable.contains(x) || valTable.contains(y))
             return false;
 
-        keyTable.insert(x, y);
-        valTable.insert(y, x);
+        // Make room in a full bounded map
+        if (maxPairs > 0 && currentSize >= maxPairs && !evict())
+            return false;
+
+        watchRehash("keyTable", keyTable, [&] { keyTable.insert(x, y); });
+        watchRehash("valTable", valTable, [&] { valTable.insert(y, x); });
         currentSize++;
         return true;
     }
@@ -104,6 +249,8 @@ public:
      */
     bool containsKey(const KeyType &x) const
     {
+        if (small.isActive())
+            return small.findKey(x) != INLINE_PAIRS;
         return keyTable.contains(x);
     }
 
@@ -115,9 +262,45 @@ public:
      */
     bool containsVal(const ValType &x) const
     {
+        if (small.isActive())
+            return small.findVal(x) != INLINE_PAIRS;
         return valTable.contains(x);
     }
 
+    /**
+     * Check a batch of keys. For int keys the table checks 8 at a
+     * time with AVX2 where the CPU has it.
+     *
+     * @param xs The keys to check.
+     * @param n The number of keys.
+     * @param found Set found[i] to true iff xs[i] is the key of a pair.
+     */
+    void containsKeys(const KeyType *xs, size_t n, bool *found) const
+    {
+        if (small.isActive())
+            for (size_t i = 0; i < n; i++)
+                found[i] = small.findKey(xs[i]) != INLINE_PAIRS;
+        else
+            keyTable.containsBatch(xs, n, found);
+    }
+
+    /**
+     * Check a batch of values. For int values the table checks 8 at
+     * a time with AVX2 where the CPU has it.
+     *
+     * @param xs The values to check.
+     * @param n The number of values.
+     * @param found Set found[i] to true iff xs[i] is the value of a pair.
+     */
+    void containsVals(const ValType *xs, size_t n, bool *found) const
+    {
+        if (small.isActive())
+            for (size_t i = 0; i < n; i++)
+                found[i] = small.findVal(xs[i]) != INLINE_PAIRS;
+        else
+            valTable.containsBatch(xs, n, found);
+    }
+
     /**
      * Remove the key-value pair with the specified key.
      *
@@ -126,11 +309,19 @@ public:
      */
     bool removeKey(const KeyType &x)
     {
+        typename Instrumentation::Scope scope(instrumentation, OP_REMOVE_KEY);
+
+        if (small.isActive())
+            return removeSmall(small.findKey(x));
+
         if (!keyTable.contains(x))
             return false;
 
-        valTable.remove(getVal(x));
-        keyTable.remove(x);
+        ValType y = keyTable.getVal(x);
+        keyCache.erase(x);
+        valCache.erase(y);
+        watchRehash("valTable", valTable, [&] { valTable.remove(y); });
+        watchRehash("keyTable", keyTable, [&] { keyTable.remove(x); });
         currentSize--;
         return true;
     }
@@ -143,15 +334,180 @@ public:
      */
     bool removeVal(const ValType &x)
     {
+        typename Instrumentation::Scope scope(instrumentation, OP_REMOVE_VAL);
+
+        if (small.isActive())
+            return removeSmall(small.findVal(x));
+
         if (!valTable.contains(x))
             return false;
 
-        keyTable.remove(getKey(x));
-        valTable.remove(x);
+        KeyType y = valTable.getVal(x);
+        keyCache.erase(y);
+        valCache.erase(x);
+        watchRehash("keyTable", keyTable, [&] { keyTable.remove(y); });
+        watchRehash("valTable", valTable, [&] { valTable.remove(x); });
         currentSize--;
         return true;
     }
 
+    /**
+     * Apply a transaction: check every entry against the map and the
+     * rest of the batch, then apply them all, or none if any entry
+     * conflicts. Removals take effect before inserts. Both tables are
+     * sized for the batch before the first change, and removals do not
+     * shrink them, so neither rehashes midway.
+     *
+     * Only an exception thrown while copying a key or value can leave
+     * the batch half applied.
+     *
+     * @param tx The transaction.
+     * @param conflicts Set to the conflicting entries in entry order;
+     *        empty if the transaction was applied.
+     * @return True if the transaction was applied.
+     * @throws std::length_error If the tables would be too large; the
+     *         map is then unchanged.
+     */
+    bool apply(const Transaction &tx, vector<BiMapConflict> &conflicts)
+    {
+        typename Instrumentation::Scope scope(instrumentation, OP_APPLY);
+
+        conflicts.clear();
+        size_t removals = tx.getSize() - tx.getInserts();
+
+        // The keys and values of the pairs the removals remove and of
+        // the pairs the inserts add, each with its entry
+        HashTable<KeyType, size_t> removedKeys(0), addedKeys(0);
+        HashTable<ValType, size_t> removedVals(0), addedVals(0);
+        removedKeys.reserve(removals);
+        removedVals.reserve(removals);
+        addedKeys.reserve(tx.getInserts());
+        addedVals.reserve(tx.getInserts());
+
+        vector<pair<KeyType, ValType>> removed;
+        removed.reserve(removals);
+        for (size_t i = 0; i < tx.getSize(); i++)
+        {
+            const auto &e = tx.getEntry(i);
+            if (e.type == Transaction::REMOVE_KEY)
+            {
+                const ValType *y = findPairVal(e.key);
+                if (y == nullptr || removedKeys.contains(e.key))
+                {
+                    conflicts.push_back(BiMapConflict{i, KEY_NOT_FOUND, i});
+                    continue;
+                }
+                removed.emplace_back(e.key, *y);
+            }
+            else if (e.type == Transaction::REMOVE_VAL)
+            {
+                const KeyType *x = findPairKey(e.val);
+                if (x == nullptr || removedVals.contains(e.val))
+                {
+                    conflicts.push_back(BiMapConflict{i, VAL_NOT_FOUND, i});
+                    continue;
+                }
+                removed.emplace_back(*x, e.val);
+            }
+            else
+                continue;
+            removedKeys.insert(removed.back().first, i);
+            removedVals.insert(removed.back().second, i);
+        }
+
+        size_t pairs = currentSize - removed.size();
+        for (size_t i = 0; i < tx.getSize(); i++)
+        {
+            const auto &e = tx.getEntry(i);
+            if (e.type != Transaction::INSERT)
+                continue;
+
+            const size_t *other = addedKeys.find(e.key);
+            if (other != nullptr)
+                conflicts.push_back(BiMapConflict{i, KEY_IN_BATCH, *other});
+            else if (containsKey(e.key) && !removedKeys.contains(e.key))
+                conflicts.push_back(BiMapConflict{i, KEY_IN_MAP, i});
+
+            other = addedVals.find(e.val);
+            if (other != nullptr)
+                conflicts.push_back(BiMapConflict{i, VAL_IN_BATCH, *other});
+            else if (containsVal(e.val) && !removedVals.contains(e.val))
+                conflicts.push_back(BiMapConflict{i, VAL_IN_MAP, i});
+
+            if (maxPairs > 0 && ++pairs > maxPairs)
+                conflicts.push_back(BiMapConflict{i, MAP_FULL, i});
+            addedKeys.insert(e.key, i);
+            addedVals.insert(e.val, i);
+        }
+
+        if (!conflicts.empty())
+        {
+            stable_sort(conflicts.begin(), conflicts.end(),
+                        [](const BiMapConflict &a, const BiMapConflict &b)
+                        { return a.entry < b.entry; });
+            return false;
+        }
+
+        size_t newSize = currentSize - removed.size() + tx.getInserts();
+        if (small.isActive() && newSize <= INLINE_PAIRS)
+        {
+            for (auto &p : removed)
+                removeSmall(small.findKey(p.first));
+            for (size_t i = 0; i < tx.getSize(); i++)
+                if (tx.getEntry(i).type == Transaction::INSERT)
+                    small.add(tx.getEntry(i).key, tx.getEntry(i).val);
+            currentSize = (SizeType)newSize;
+            return true;
+        }
+
+        // Make room for the old pairs and the new ones together, as the
+        // slots of removed pairs stay DELETED
+        if (small.isActive())
+            moveToTables();
+        size_t peak = currentSize + tx.getInserts();
+        watchRehash("keyTable", keyTable, [&] { keyTable.reserve(peak); });
+        watchRehash("valTable", valTable, [&] { valTable.reserve(peak); });
+
+        double keyShrink = keyTable.getShrinkThreshold();
+        double valShrink = valTable.getShrinkThreshold();
+        keyTable.setShrinkThreshold(0);
+        valTable.setShrinkThreshold(0);
+        for (auto &p : removed)
+        {
+            keyCache.erase(p.first);
+            valCache.erase(p.second);
+            keyTable.remove(p.first);
+            valTable.remove(p.second);
+        }
+        for (size_t i = 0; i < tx.getSize(); i++)
+        {
+            const auto &e = tx.getEntry(i);
+            if (e.type == Transaction::INSERT)
+            {
+                keyTable.insert(e.key, e.val);
+                valTable.insert(e.val, e.key);
+            }
+        }
+        keyTable.setShrinkThreshold(keyShrink);
+        valTable.setShrinkThreshold(valShrink);
+
+        currentSize = (SizeType)newSize;
+        return true;
+    }
+
+    /**
+     * Apply a transaction, all of it or none of it.
+     *
+     * @param tx The transaction.
+     * @return True if the transaction was applied.
+     * @throws std::length_error If the tables would be too large.
+     */
+    bool apply(const Transaction &tx)
+    {
+        vector<BiMapConflict> conflicts;
+        return apply(tx, conflicts);
+    }
+
     /**
      * Get the key associated with a specific value.
      *
@@ -161,9 +517,39 @@ public:
      */
     const KeyType getKey(const ValType &x) const
     {
-        if (!valTable.contains(x))
+        typename Instrumentation::Scope scope(instrumentation, OP_GET_KEY);
+
+        if (small.isActive())
+        {
+            size_t i = small.findVal(x);
+            if (i == INLINE_PAIRS)
+                throw std::runtime_error("Value not found in map.");
+            return small.key(i);
+        }
+
+        if (valCache.isEnabled())
+            if (const KeyType *cached = valCache.find(x))
+            {
+                if (maxPairs > 0)
+                    ++hits;
+                return *cached;
+            }
+
+        const KeyType *key = valTable.find(x);
+        if (key == nullptr)
+        {
+            if (maxPairs > 0)
+                ++misses;
             throw std::runtime_error("Value not found in map.");
-        return valTable.getVal(x);
+        }
+        if (valCache.isEnabled())
+            valCache.store(x, *key);
+        if (maxPairs > 0)
+        {
+            ++hits;
+            keyTable.touch(*key);
+        }
+        return *key;
     }
 
     /**
@@ -175,15 +561,394 @@ public:
      */
     const ValType getVal(const KeyType &x) const
     {
-        if (!keyTable.contains(x))
+        typename Instrumentation::Scope scope(instrumentation, OP_GET_VAL);
+
+        if (small.isActive())
+        {
+            size_t i = small.findKey(x);
+            if (i == INLINE_PAIRS)
+                throw std::runtime_error("Key not found in map.");
+            return small.value(i);
+        }
+
+        if (keyCache.isEnabled())
+            if (const ValType *cached = keyCache.find(x))
+            {
+                if (maxPairs > 0)
+                    ++hits;
+                return *cached;
+            }
+
+        const ValType *val = keyTable.find(x);
+        if (val == nullptr)
+        {
+            if (maxPairs > 0)
+                ++misses;
             throw std::runtime_error("Key not found in map.");
-        return keyTable.getVal(x);
+        }
+        if (maxPairs > 0)
+            ++hits;
+        if (keyCache.isEnabled())
+            keyCache.store(x, *val);
+        return *val;
+    }
+
+    /**
+     * Call f(key, value) for every key-value pair in the map,
+     * in no particular order.
+     *
+     * @param f The visitor to call.
+     */
+    template <typename Visitor>
+    void forEachPair(Visitor f) const
+    {
+        for (size_t i = 0; i < small.getSize(); i++)
+            f(small.key(i), small.value(i));
+        keyTable.forEach(f);
+    }
+
+    /**
+     * Report the memory used by the map, summed over keyTable and
+     * valTable. Keys and values are counted once in each table.
+     * Inline pairs are slots in the map object: they count towards
+     * capacity and activeSlots, and their bytes towards objectBytes.
+     * The lines of the front caches count towards slotBytes and, as
+     * they only copy pairs the tables hold, overheadBytes.
+     *
+     * @return The memory usage of the map.
+     */
+    MemoryUsage memoryUsage() const
+    {
+        static PayloadHeapBytes<KeyType> keyBytes;
+        static PayloadHeapBytes<ValType> valBytes;
+
+        MemoryUsage usage = keyTable.memoryUsage();
+        usage += valTable.memoryUsage();
+        usage.objectBytes = sizeof(*this);
+        size_t cacheBytes = keyCache.memoryBytes() + valCache.memoryBytes();
+        usage.slotBytes += cacheBytes;
+        usage.overheadBytes += cacheBytes;
+        if (small.isActive())
+        {
+            usage.capacity += INLINE_PAIRS;
+            usage.activeSlots += small.getSize();
+            for (size_t i = 0; i < small.getSize(); i++)
+                usage.payloadHeapBytes += keyBytes(small.key(i)) + valBytes(small.value(i));
+        }
+        return usage;
+    }
+
+    /**
+     * Set the live load below which removals shrink the tables.
+     *
+     * @param fraction The shrink threshold in [0, 0.25); 0 turns it off.
+     * @throws IllegalArgumentException If fraction is out of range.
+     */
+    void setShrinkThreshold(double fraction)
+    {
+        keyTable.setShrinkThreshold(fraction);
+        valTable.setShrinkThreshold(fraction);
+    }
+
+    /**
+     * Shrink both tables to the smallest size that holds the pairs.
+     * A map with a small mode whose pairs fit inline moves them there
+     * and gives back both tables instead. A bounded map keeps its
+     * tables, which are sized so that they never rehash to grow.
+     */
+    void shrinkToFit()
+    {
+        if (small.isActive() || maxPairs > 0)
+            return;
+        if (hasSmallMode(maxPairs) && currentSize <= INLINE_PAIRS)
+        {
+            moveInline();
+            return;
+        }
+        watchRehash("keyTable", keyTable, [&] { keyTable.shrinkToFit(); });
+        watchRehash("valTable", valTable, [&] { valTable.shrinkToFit(); });
+    }
+
+    /**
+     * Check if the map is in small mode.
+     *
+     * @return True if the pairs are kept inline.
+     */
+    bool isSmall() const { return small.isActive(); }
+
+    /**
+     * Put a small direct-mapped cache of recent lookups in front of
+     * each table: getVal( ) results in front of keyTable, getKey( )
+     * results in front of valTable. A hit skips the hash table probe,
+     * which pays off when a few keys get most lookups. Removals and
+     * evictions drop their pairs from the caches. Inserts leave them
+     * as they are: an insert only adds a key and a value that are in
+     * no pair, so neither cache can hold them.
+     *
+     * @param slots The entries per cache, rounded up to fill whole
+     *        cache lines; 0 turns the caches off.
+     */
+    void setFrontCacheSize(size_t slots)
+    {
+        keyCache.setSize(slots);
+        valCache.setSize(slots);
     }
 
+    /**
+     * Get the maximum number of pairs of a bounded map.
+     *
+     * @return The pair limit, or 0 if the map is unbounded.
+     */
+    size_t getMaxPairs() const { return maxPairs; }
+
+    /**
+     * Get the number of getVal/getKey calls that found their pair.
+     * Only counted for a bounded map.
+     *
+     * @return The number of hits.
+     */
+    size_t getHits() const { return hits; }
+
+    /**
+     * Get the number of getVal/getKey calls that did not find their
+     * pair. Only counted for a bounded map.
+     *
+     * @return The number of misses.
+     */
+    size_t getMisses() const { return misses; }
+
+    /**
+     * Get the number of pairs evicted to make room for new ones.
+     *
+     * @return The number of evictions.
+     */
+    size_t getEvictions() const { return evictions; }
+
+    /**
+     * Take a read-only view of the map as it is now. Later changes to
+     * the map do not show in it, and other threads may read it while
+     * this thread keeps changing the map.
+     *
+     * With CowBiMapTraits this costs O(1): the view shares the slot
+     * pages of the tables, and a change to the map copies only the
+     * pages it writes to while a view still uses them. With other
+     * traits it copies both tables.
+     *
+     * @return The view.
+     */
+    BiMapSnapshot<KeyType, ValType, Traits> snapshot() const
+    {
+        return BiMapSnapshot<KeyType, ValType, Traits>(
+            keyTable.snapshot(), valTable.snapshot(), small, currentSize);
+    }
+
+    /**
+     * Get the instrumentation policy of the map.
+     *
+     * @return The policy, e.g. a LatencyInstrumentation.
+     */
+    Instrumentation &getInstrumentation() { return instrumentation; }
+    const Instrumentation &getInstrumentation() const { return instrumentation; }
+
 private:
-    HashTable<KeyType, ValType> keyTable; // To hold map key->value pair
-    HashTable<ValType, KeyType> valTable; // To hold map value->key pair
-    int currentSize;                      // The current size of the map
+    // To hold map key->value pair
+    HashTable<KeyType, ValType, typename Traits::KeyTableTraits> keyTable;
+    // To hold map value->key pair
+    HashTable<ValType, KeyType, typename Traits::ValTableTraits> valTable;
+    typedef typename Traits::SizeType SizeType;
+
+    static const size_t INLINE_PAIRS = Traits::InlinePairs;
+
+    SizeType currentSize;                 // The current size of the map
+    SizeType maxPairs;                    // The pair limit, 0 if unbounded
+    mutable size_t hits;                  // Lookups that found a pair
+    mutable size_t misses;                // Lookups that found no pair
+    size_t evictions;                     // Pairs evicted when full
+
+    mutable FrontCache<KeyType, ValType> keyCache; // Recent getVal results
+    mutable FrontCache<ValType, KeyType> valCache; // Recent getKey results
+
+    // The pairs of a map in small mode; takes no space without one
+    [[no_unique_address]] InlinePairArray<KeyType, ValType, INLINE_PAIRS> small;
+
+    // Records latencies; takes no space when it is NoInstrumentation
+    [[no_unique_address]] Instrumentation instrumentation;
+
+    /**
+     * Get the initial size of the tables: a bounded map needs room
+     * for 4 * maxPairs entries.
+     *
+     * @param size The requested size.
+     * @param maxPairs The pair limit, 0 if unbounded.
+     * @return The size to pass to the tables.
+     * @throws std::length_error If 4 * maxPairs overflows.
+     */
+    static size_t tableSize(size_t size, size_t maxPairs)
+    {
+        if (maxPairs > numeric_limits<SizeType>::max() / 4)
+            throw length_error("BiMap: too many pairs");
+        return max(size, 4 * maxPairs);
+    }
+
+    /**
+     * Check if a map has a small mode. Bounded maps do not, as they
+     * need keyTable for CLOCK.
+     *
+     * @param maxPairs The pair limit, 0 if unbounded.
+     * @return True if the map starts out with its pairs inline.
+     */
+    static bool hasSmallMode(size_t maxPairs)
+    {
+        return INLINE_PAIRS > 0 && maxPairs == 0;
+    }
+
+    /**
+     * Remove an inline pair.
+     *
+     * @param i The position of the pair, INLINE_PAIRS if there is none.
+     * @return True if a pair was removed.
+     */
+    bool removeSmall(size_t i)
+    {
+        if (i == INLINE_PAIRS)
+            return false;
+        small.removeAt(i);
+        currentSize--;
+        return true;
+    }
+
+    /**
+     * Find the value of the pair with a key, inline or in keyTable,
+     * without touching the front caches or the statistics.
+     *
+     * @param x The key.
+     * @return The value, or nullptr if no pair has key x.
+     */
+    const ValType *findPairVal(const KeyType &x) const
+    {
+        if (small.isActive())
+        {
+            size_t i = small.findKey(x);
+            return i == INLINE_PAIRS ? nullptr : &small.value(i);
+        }
+        return keyTable.find(x);
+    }
+
+    /**
+     * Find the key of the pair with a value, inline or in valTable,
+     * without touching the front caches or the statistics.
+     *
+     * @param y The value.
+     * @return The key, or nullptr if no pair has value y.
+     */
+    const KeyType *findPairKey(const ValType &y) const
+    {
+        if (small.isActive())
+        {
+            size_t i = small.findVal(y);
+            return i == INLINE_PAIRS ? nullptr : &small.key(i);
+        }
+        return valTable.find(y);
+    }
+
+    /**
+     * Leave small mode: create the tables and move the inline pairs
+     * into them.
+     */
+    void moveToTables()
+    {
+        watchRehash("keyTable", keyTable, [&] { keyTable.reserve(2 * INLINE_PAIRS); });
+        watchRehash("valTable", valTable, [&] { valTable.reserve(2 * INLINE_PAIRS); });
+        for (size_t i = 0; i < small.getSize(); i++)
+        {
+            keyTable.insert(small.key(i), small.value(i));
+            valTable.insert(small.value(i), small.key(i));
+        }
+        small.clear();
+        small.setActive(false);
+    }
+
+    /**
+     * Enter small mode: move the pairs inline and give back the
+     * tables. The pairs must fit.
+     */
+    void moveInline()
+    {
+        small.setActive(true);
+        keyTable.forEach([&](const KeyType &k, const ValType &v)
+                         { small.add(k, v); });
+        keyTable.makeEmpty();
+        valTable.makeEmpty();
+        keyCache.clear();
+        valCache.clear();
+    }
+
+    /**
+     * Run an operation on a table that may rehash it, and report
+     * any rehash to the instrumentation policy.
+     *
+     * @param name The name of the table.
+     * @param table The table.
+     * @param op The operation.
+     */
+    template <typename Table, typename Op>
+    void watchRehash(const char *name, const Table &table, Op op)
+    {
+        if constexpr (!Instrumentation::enabled)
+            op();
+        else
+        {
+            // A rehash at the same size leaves the capacity as it
+            // was, so count rehashes rather than compare capacities
+            size_t oldCapacity = table.getCapacity();
+            size_t oldRehashes = table.getRehashes();
+            auto start = chrono::steady_clock::now();
+            op();
+            if (table.getRehashes() != oldRehashes)
+                instrumentation.onRehash(RehashEvent{name, oldCapacity,
+                                                     table.getCapacity(),
+                                                     elapsedNanos(start)});
+        }
+    }
+
+    /**
+     * Evict the pair the CLOCK policy picks from keyTable. Lookups
+     * served by a front cache never reach keyTable, so a pair found
+     * in a front cache is dropped from it and gets one more chance.
+     *
+     * @return True if a pair was evicted.
+     */
+    bool evict()
+    {
+        KeyType key;
+        ValType val;
+        auto wasCached = [&](const KeyType &k, const ValType &v)
+        {
+            bool inKeyCache = keyCache.erase(k);
+            bool inValCache = valCache.erase(v);
+            return inKeyCache || inValCache;
+        };
+        if (!keyTable.evict(key, val, wasCached))
+            return false;
+
+        keyCache.erase(key);
+        valCache.erase(val);
+        valTable.remove(val);
+        currentSize--;
+        evictions++;
+        return true;
+    }
 };
 
+// Compiled once, into libbimap (BiMapInstances.cpp)
+extern template class BiMap<int, int>;
+extern template class BiMap<int, int64_t>;
+extern template class BiMap<int, string>;
+extern template class BiMap<int64_t, int>;
+extern template class BiMap<int64_t, int64_t>;
+extern template class BiMap<int64_t, string>;
+extern template class BiMap<string, int>;
+extern template class BiMap<string, int64_t>;
+extern template class BiMap<string, string>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file compiles BiMap, and the HashTables behind it, for every
+pair of int, int64_t and string into libbimap, once, for the extern
+templates in BiMap.h and QuadraticProbingBiMap.h.
+*/
+#include <cstdint>
+#include <string>
+#include "BiMap.h"
+using namespace std;
+
+template class HashTable<int, int>;
+template class HashTable<int, int64_t>;
+template class HashTable<int, string>;
+template class HashTable<int64_t, int>;
+template class HashTable<int64_t, int64_t>;
+template class HashTable<int64_t, string>;
+template class HashTable<string, int>;
+template class HashTable<string, int64_t>;
+template class HashTable<string, string>;
+
+template class BiMap<int, int>;
+template class BiMap<int, int64_t>;
+template class BiMap<int, string>;
+template class BiMap<int64_t, int>;
+template class BiMap<int64_t, int64_t>;
+template class BiMap<int64_t, string>;
+template class BiMap<string, int>;
+template class BiMap<string, int64_t>;
+template class BiMap<string, string>;
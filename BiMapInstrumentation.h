@@ -0,0 +1,271 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the instrumentation policies of the BiMap class.
+NoInstrumentation compiles to nothing; LatencyInstrumentation keeps
+a latency histogram per operation and reports every rehash.
+*/
+#ifndef BI_MAP_INSTRUMENTATION_H
+#define BI_MAP_INSTRUMENTATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+using namespace std;
+
+/**
+ * The BiMap operations that are timed.
+ */
+enum BiMapOp
+{
+    OP_INSERT,     // insert( )
+    OP_GET_VAL,    // getVal( )
+    OP_GET_KEY,    // getKey( )
+    OP_REMOVE_KEY, // removeKey( )
+    OP_REMOVE_VAL, // removeVal( )
+    OP_APPLY,      // apply( )
+    OP_REHASH,     // A rehash of keyTable or valTable
+    OP_COUNT       // The number of operations
+};
+
+/**
+ * Describes one rehash of a BiMap table.
+ */
+struct RehashEvent
+{
+    const char *table;  // "keyTable" or "valTable"
+    size_t oldCapacity; // The size of the array before the rehash
+    size_t newCapacity; // The size of the array after the rehash
+    uint64_t nanos;     // How long the rehash took
+};
+
+/**
+ * Get the nanoseconds elapsed since a time point.
+ *
+ * @param start The time point.
+ * @return The nanoseconds from start until now.
+ */
+inline uint64_t elapsedNanos(chrono::steady_clock::time_point start)
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now() - start).count();
+}
+
+// Instrumentation policies
+//
+// ******************REQUIRED MEMBERS**********************
+// static const bool enabled  --> False if the policy records nothing
+// class Scope( p, op )       --> Times op for as long as it lives
+// void onRehash( e ) const   --> Called after every rehash
+
+/**
+ * Instrumentation policy that records nothing. It is empty, and
+ * its Scope does nothing, so it costs nothing.
+ */
+struct NoInstrumentation
+{
+    static const bool enabled = false;
+
+    struct Scope
+    {
+        Scope(const NoInstrumentation &, BiMapOp) {}
+    };
+
+    void onRehash(const RehashEvent &) const {}
+};
+
+// Latency histogram
+//
+// CONSTRUCTION: empty
+//
+// Counts latencies in log-scaled buckets, HDR style: each power of two
+// is split into 8 linear sub-buckets, so a bucket's bounds are within
+// 12.5% of each other, from 1ns up to about 18 minutes.
+//
+// ******************PUBLIC OPERATIONS*********************
+// void record( ns )          --> Count a latency of ns nanoseconds
+// uint64_t getCount( )       --> Return the number of latencies
+// uint64_t getMax( )         --> Return the largest latency
+// uint64_t percentile( p )   --> Return an upper bound on the p-th
+//                                percentile, p in [0, 100]
+// void reset( )              --> Forget all latencies
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() { reset(); }
+
+    /**
+     * Count a latency.
+     *
+     * @param nanos The latency in nanoseconds.
+     */
+    void record(uint64_t nanos)
+    {
+        ++counts[bucketOf(nanos)];
+        ++count;
+        if (nanos > maxNanos)
+            maxNanos = nanos;
+    }
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMax() const { return maxNanos; }
+
+    /**
+     * Get an upper bound on a percentile of the latencies.
+     *
+     * @param p The percentile, in [0, 100].
+     * @return The upper bound of the bucket holding the percentile,
+     *         capped at the largest latency; 0 if there are none.
+     */
+    uint64_t percentile(double p) const
+    {
+        uint64_t rank = (uint64_t)(p / 100.0 * count + 0.5);
+        if (rank == 0)
+            rank = 1;
+
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += counts[b];
+            if (seen >= rank)
+                return min(upperBound(b), maxNanos);
+        }
+        return maxNanos;
+    }
+
+    /**
+     * Forget all latencies.
+     */
+    void reset()
+    {
+        for (auto &c : counts)
+            c = 0;
+        count = 0;
+        maxNanos = 0;
+    }
+
+private:
+    static const int SUB_BITS = 3;                 // 8 sub-buckets
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int BUCKETS = (40 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    uint64_t counts[BUCKETS]; // The number of latencies in each bucket
+    uint64_t count;           // The number of latencies
+    uint64_t maxNanos;        // The largest latency
+
+    /**
+     * Find the bucket of a latency. Latencies below SUB_BUCKETS
+     * get a bucket each; above, a bucket is 1/8 of a power of two.
+     */
+    static int bucketOf(uint64_t nanos)
+    {
+        if (nanos < (uint64_t)SUB_BUCKETS)
+            return (int)nanos;
+
+        int exponent = 63 - __builtin_clzll(nanos); // >= SUB_BITS
+        int sub = (int)(nanos >> (exponent - SUB_BITS)) - SUB_BUCKETS;
+        int bucket = (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+        return bucket < BUCKETS ? bucket : BUCKETS - 1;
+    }
+
+    /**
+     * Get the largest latency that falls in a bucket.
+     */
+    static uint64_t upperBound(int bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+            return (uint64_t)bucket;
+
+        int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS);
+        return ((sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+};
+
+/**
+ * Instrumentation policy that keeps a latency histogram per BiMap
+ * operation and calls a hook after every rehash. Reading the clock
+ * twice is the only cost added to an operation.
+ */
+class LatencyInstrumentation
+{
+public:
+    static const bool enabled = true;
+
+    /**
+     * Times one operation from construction to destruction.
+     */
+    class Scope
+    {
+    public:
+        Scope(const LatencyInstrumentation &owner, BiMapOp op)
+            : owner(owner), op(op), start(chrono::steady_clock::now()) {}
+
+        ~Scope()
+        {
+            owner.histograms[op].record(elapsedNanos(start));
+        }
+
+    private:
+        const LatencyInstrumentation &owner;
+        BiMapOp op;
+        chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Get the latency histogram of an operation.
+     *
+     * @param op The operation.
+     * @return The histogram of its latencies.
+     */
+    const LatencyHistogram &getHistogram(BiMapOp op) const
+    {
+        return histograms[op];
+    }
+
+    /**
+     * Set the hook called after every rehash.
+     *
+     * @param hook The function to call with the rehash event.
+     */
+    void setRehashHook(function<void(const RehashEvent &)> hook)
+    {
+        rehashHook = std::move(hook);
+    }
+
+    /**
+     * Record a rehash and pass it to the hook.
+     *
+     * @param e The rehash event.
+     */
+    void onRehash(const RehashEvent &e) const
+    {
+        histograms[OP_REHASH].record(e.nanos);
+        if (rehashHook)
+            rehashHook(e);
+    }
+
+    /**
+     * Forget all recorded latencies.
+     */
+    void reset()
+    {
+        for (auto &h : histograms)
+            h.reset();
+    }
+
+private:
+    mutable LatencyHistogram histograms[OP_COUNT]; // One per operation
+    function<void(const RehashEvent &)> rehashHook;  // Called on rehash
+};
+
+#endif
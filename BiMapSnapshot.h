@@ -0,0 +1,186 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a BiMapSnapshot class, a read-only
+view of a BiMap at the time BiMap::snapshot( ) was called.
+*/
+#ifndef BI_MAP_SNAPSHOT_H
+#define BI_MAP_SNAPSHOT_H
+
+#include <stdexcept>
+#include "QuadraticProbingBiMap.h"
+#include "InlinePairArray.h"
+using namespace std;
+
+template <typename KeyType, typename ValType, typename Traits>
+class BiMap;
+
+// Bijective Map snapshot class
+//
+// CONSTRUCTION: from BiMap::snapshot( ); copies share the snapshot
+//
+// Holds its own copies of the BiMap's tables, which share their slot
+// pages with the map under CowBiMapTraits, and of its inline pairs.
+// Reading a snapshot never writes, so any number of threads may read
+// one at once.
+//
+// ******************PUBLIC OPERATIONS*********************
+// size_t getSize() const     --> Return the number of pairs
+// bool containsKey(x)        --> Return true if x is the key of a pair
+// bool containsVal(x)        --> Return true if x is the value of a pair
+// const ValType getVal(x)    --> Return the value associated with key x
+// const KeyType getKey(x)    --> Return the key associated with value x
+// void forEachPair(f)        --> Call f(x, y) for every pair <x,y>
+// MemoryUsage memoryUsage()  --> Return the memory used by both tables
+
+template <typename KeyType, typename ValType, typename Traits>
+class BiMapSnapshot
+{
+public:
+    /**
+     * Get the number of key-value pairs in the snapshot.
+     *
+     * @return The number of pairs.
+     */
+    size_t getSize() const { return currentSize; }
+
+    /**
+     * Check if the snapshot contains a specific key.
+     *
+     * @param x The key to check.
+     * @return True if the key exists in the snapshot, false otherwise.
+     */
+    bool containsKey(const KeyType &x) const
+    {
+        if (small.isActive())
+            return small.findKey(x) != INLINE_PAIRS;
+        return keyTable.contains(x);
+    }
+
+    /**
+     * Check if the snapshot contains a specific value.
+     *
+     * @param x The value to check.
+     * @return True if the value exists in the snapshot, false otherwise.
+     */
+    bool containsVal(const ValType &x) const
+    {
+        if (small.isActive())
+            return small.findVal(x) != INLINE_PAIRS;
+        return valTable.contains(x);
+    }
+
+    /**
+     * Get the key associated with a specific value.
+     *
+     * @param x The value to look up.
+     * @return The key associated with the value.
+     * @throws std::runtime_error If the value is not found in the snapshot.
+     */
+    const KeyType getKey(const ValType &x) const
+    {
+        if (small.isActive())
+        {
+            size_t i = small.findVal(x);
+            if (i == INLINE_PAIRS)
+                throw std::runtime_error("Value not found in map.");
+            return small.key(i);
+        }
+
+        const KeyType *key = valTable.find(x);
+        if (key == nullptr)
+            throw std::runtime_error("Value not found in map.");
+        return *key;
+    }
+
+    /**
+     * Get the value associated with a specific key.
+     *
+     * @param x The key to look up.
+     * @return The value associated with the key.
+     * @throws std::runtime_error If the key is not found in the snapshot.
+     */
+    const ValType getVal(const KeyType &x) const
+    {
+        if (small.isActive())
+        {
+            size_t i = small.findKey(x);
+            if (i == INLINE_PAIRS)
+                throw std::runtime_error("Key not found in map.");
+            return small.value(i);
+        }
+
+        const ValType *val = keyTable.find(x);
+        if (val == nullptr)
+            throw std::runtime_error("Key not found in map.");
+        return *val;
+    }
+
+    /**
+     * Call f(key, value) for every key-value pair in the snapshot,
+     * in no particular order.
+     *
+     * @param f The visitor to call.
+     */
+    template <typename Visitor>
+    void forEachPair(Visitor f) const
+    {
+        for (size_t i = 0; i < small.getSize(); i++)
+            f(small.key(i), small.value(i));
+        keyTable.forEach(f);
+    }
+
+    /**
+     * Report the memory used by the snapshot. Pages still shared with
+     * the map or other snapshots are counted in sharedBytes.
+     *
+     * @return The memory usage of the snapshot.
+     */
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage = keyTable.memoryUsage();
+        usage += valTable.memoryUsage();
+        usage.objectBytes = sizeof(*this);
+        return usage;
+    }
+
+private:
+    typedef HashTable<KeyType, ValType, typename Traits::KeyTableTraits> KeyTable;
+    typedef HashTable<ValType, KeyType, typename Traits::ValTableTraits> ValTable;
+
+    static const size_t INLINE_PAIRS = Traits::InlinePairs;
+    typedef InlinePairArray<KeyType, ValType, INLINE_PAIRS> InlinePairs;
+
+    friend class BiMap<KeyType, ValType, Traits>;
+
+    KeyTable keyTable;  // The key->value pairs
+    ValTable valTable;  // The value->key pairs
+    size_t currentSize; // The number of pairs
+
+    // The pairs of a map in small mode
+    [[no_unique_address]] InlinePairs small;
+
+    /**
+     * Constructor, for BiMap::snapshot( ).
+     *
+     * @param keyTable A snapshot of the map's keyTable.
+     * @param valTable A snapshot of the map's valTable.
+     * @param small The map's inline pairs.
+     * @param size The number of pairs.
+     */
+    BiMapSnapshot(KeyTable &&keyTable, ValTable &&valTable,
+                  const InlinePairs &small, size_t size)
+        : keyTable(std::move(keyTable)), valTable(std::move(valTable)),
+          currentSize(size), small(small)
+    {
+    }
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a BiMapTransaction class, a batch of
+inserts and removals that BiMap::apply( ) applies all at once or not
+at all, and for BiMapConflict, which says why it was not applied.
+*/
+#ifndef BI_MAP_TRANSACTION_H
+#define BI_MAP_TRANSACTION_H
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+/**
+ * Why an entry of a transaction stops it from being applied.
+ */
+enum BiMapConflictReason
+{
+    KEY_IN_MAP,    // insert: the key is the key of a pair that stays
+    VAL_IN_MAP,    // insert: the value is the value of a pair that stays
+    KEY_IN_BATCH,  // insert: an earlier insert has the same key
+    VAL_IN_BATCH,  // insert: an earlier insert has the same value
+    KEY_NOT_FOUND, // removeKey: no pair has the key, or an earlier
+                   // removal already removes it
+    VAL_NOT_FOUND, // removeVal: no pair has the value, or an earlier
+                   // removal already removes it
+    MAP_FULL       // insert: the pairs would exceed the map's maxPairs
+};
+
+/**
+ * A conflicting entry of a transaction.
+ */
+struct BiMapConflict
+{
+    size_t entry;               // The position of the entry in the transaction
+    BiMapConflictReason reason; // What is wrong with it
+    size_t other;               // For KEY_IN_BATCH and VAL_IN_BATCH, the
+                                // earlier entry; otherwise entry
+};
+
+// BiMap transaction class
+//
+// CONSTRUCTION: empty
+//
+// Records inserts and removals for BiMap::apply( ), which checks the
+// whole batch against the map and then applies every entry or none.
+// All removals take effect before any insert, so a batch can remove a
+// pair and insert its key or value in a new pair, e.g. to renumber a
+// block of IDs. Entries are numbered from 0 in the order they are added.
+//
+// ******************PUBLIC OPERATIONS*********************
+// void insert(x, y)          --> Add an insert of the pair <x,y>
+// void removeKey(x)          --> Add a removal of the pair with key x
+// void removeVal(y)          --> Add a removal of the pair with value y
+// size_t getSize() const     --> Return the number of entries
+// size_t getInserts() const  --> Return the number of inserts
+// const Entry &getEntry(i)   --> Return entry i
+// void clear()               --> Remove all entries
+
+template <typename KeyType, typename ValType>
+class BiMapTransaction
+{
+public:
+    /**
+     * The kind of an entry.
+     */
+    enum EntryType
+    {
+        INSERT,     // Insert <key, val>
+        REMOVE_KEY, // Remove the pair with key
+        REMOVE_VAL  // Remove the pair with val
+    };
+
+    /**
+     * An entry; only the fields its type uses are set.
+     */
+    struct Entry
+    {
+        EntryType type;
+        KeyType key;
+        ValType val;
+    };
+
+    BiMapTransaction() : inserts(0) {}
+
+    /**
+     * Add an insert of a pair.
+     *
+     * @param x The key.
+     * @param y The value.
+     */
+    void insert(const KeyType &x, const ValType &y)
+    {
+        entries.push_back(Entry{INSERT, x, y});
+        ++inserts;
+    }
+
+    /**
+     * Add a removal of the pair with a key.
+     *
+     * @param x The key.
+     */
+    void removeKey(const KeyType &x)
+    {
+        entries.push_back(Entry{REMOVE_KEY, x, ValType{}});
+    }
+
+    /**
+     * Add a removal of the pair with a value.
+     *
+     * @param y The value.
+     */
+    void removeVal(const ValType &y)
+    {
+        entries.push_back(Entry{REMOVE_VAL, KeyType{}, y});
+    }
+
+    size_t getSize() const { return entries.size(); }
+    size_t getInserts() const { return inserts; }
+    const Entry &getEntry(size_t i) const { return entries[i]; }
+
+    /**
+     * Remove all entries.
+     */
+    void clear()
+    {
+        entries.clear();
+        inserts = 0;
+    }
+
+private:
+    vector<Entry> entries; // The entries, in the order they were added
+    size_t inserts;        // The number of INSERT entries
+};
+
+#endif
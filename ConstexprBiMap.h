@@ -0,0 +1,277 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a ConstexprBiMap class, a fixed
+one-to-one map whose hash tables are built at compile time from
+a list of pairs. It needs C++17.
+*/
+#ifndef CONSTEXPR_BI_MAP_H
+#define CONSTEXPR_BI_MAP_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+/**
+ * Returns the smallest prime number greater than or equal to n,
+ * at compile time. Used to determine the size of the hash tables.
+ *
+ * @param n The minimum size of the hash table.
+ * @return A prime number >= n.
+ */
+constexpr size_t constexprNextPrime(size_t n)
+{
+    if (n <= 2)
+        return 2;
+    if (n % 2 == 0)
+        ++n;
+
+    for (;; n += 2)
+    {
+        bool prime = true;
+        for (size_t i = 3; i <= n / i; i += 2)
+            if (n % i == 0)
+            {
+                prime = false;
+                break;
+            }
+        if (prime)
+            return n;
+    }
+}
+
+/**
+ * Hash function usable at compile time. Specialized for integral
+ * and enum types and for string_view; other keys are not supported.
+ */
+template <typename T, typename Enable = void>
+struct ConstexprHash;
+
+template <typename T>
+struct ConstexprHash<T, typename enable_if<is_integral<T>::value ||
+                                           is_enum<T>::value>::type>
+{
+    constexpr size_t operator()(T x) const
+    {
+        // The splitmix64 finalizer
+        uint64_t h = (uint64_t)x + 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        return (size_t)(h ^ (h >> 31));
+    }
+};
+
+template <>
+struct ConstexprHash<string_view>
+{
+    constexpr size_t operator()(string_view s) const
+    {
+        // FNV-1a
+        uint64_t h = 0xCBF29CE484222325ULL;
+        for (char c : s)
+            h = (h ^ (unsigned char)c) * 0x100000001B3ULL;
+        return (size_t)h;
+    }
+};
+
+// Compile-time Bijective Map class
+//
+// CONSTRUCTION: at compile time from an array of N distinct pairs,
+//               usually through makeConstexprBiMap:
+//
+//   constexpr auto colors = makeConstexprBiMap<Color, string_view>({
+//       {Color::Red, "red"}, {Color::Green, "green"}});
+//
+// A duplicate key or value stops compilation. A lookup on a constexpr
+// map with a constant argument is folded; otherwise it reads the
+// static read-only tables, with no work done at startup.
+//
+// ******************PUBLIC OPERATIONS*********************
+// size_t getSize() const     --> Return the number of pairs
+// bool containsKey(x)        --> Return true if x is the key of a pair
+// bool containsVal(x)        --> Return true if x is the value of a pair
+// ValType getVal(x)          --> Return the value associated with key x
+// KeyType getKey(x)          --> Return the key associated with value x
+
+template <typename KeyType, typename ValType, size_t N>
+class ConstexprBiMap
+{
+public:
+    /**
+     * Constructor
+     *
+     * Builds the key and value hash tables from the pairs.
+     *
+     * @param init The pairs of the map.
+     * @throws std::logic_error If a key or value occurs twice; in a
+     *         constant expression this is a compile error.
+     */
+    constexpr explicit ConstexprBiMap(const pair<KeyType, ValType> (&init)[N])
+        : ConstexprBiMap(init, make_index_sequence<N>())
+    {
+    }
+
+    /**
+     * Get the number of key-value pairs in the map.
+     *
+     * @return The number of pairs in the map.
+     */
+    constexpr size_t getSize() const { return N; }
+
+    /**
+     * Check if the map contains a specific key.
+     *
+     * @param x The key to check.
+     * @return True if the key exists in the map, false otherwise.
+     */
+    constexpr bool containsKey(const KeyType &x) const
+    {
+        return keySlots[findKeyPos(x)] != EMPTY;
+    }
+
+    /**
+     * Check if the map contains a specific value.
+     *
+     * @param x The value to check.
+     * @return True if the value exists in the map, false otherwise.
+     */
+    constexpr bool containsVal(const ValType &x) const
+    {
+        return valSlots[findValPos(x)] != EMPTY;
+    }
+
+    /**
+     * Get the value associated with a specific key.
+     *
+     * @param x The key to look up.
+     * @return The value associated with the key.
+     * @throws std::runtime_error If the key is not found in the map.
+     */
+    constexpr ValType getVal(const KeyType &x) const
+    {
+        Index i = keySlots[findKeyPos(x)];
+        if (i == EMPTY)
+            throw std::runtime_error("Key not found in map.");
+        return pairs[i].second;
+    }
+
+    /**
+     * Get the key associated with a specific value.
+     *
+     * @param x The value to look up.
+     * @return The key associated with the value.
+     * @throws std::runtime_error If the value is not found in the map.
+     */
+    constexpr KeyType getKey(const ValType &x) const
+    {
+        Index i = valSlots[findValPos(x)];
+        if (i == EMPTY)
+            throw std::runtime_error("Value not found in map.");
+        return pairs[i].first;
+    }
+
+private:
+    // The position of a pair; the smallest type that can hold N
+    typedef typename conditional<(N < 0xFFFF), uint16_t, uint32_t>::type Index;
+
+    static constexpr size_t CAPACITY = constexprNextPrime(2 * N + 1);
+    static constexpr Index EMPTY = (Index)N; // Marks an empty slot
+
+    array<pair<KeyType, ValType>, N> pairs; // The pairs, in list order
+    array<Index, CAPACITY> keySlots;        // Key table: pair positions
+    array<Index, CAPACITY> valSlots;        // Value table: pair positions
+
+    template <size_t... I>
+    constexpr ConstexprBiMap(const pair<KeyType, ValType> (&init)[N],
+                             index_sequence<I...>)
+        : pairs{{init[I]...}}, keySlots{}, valSlots{}
+    {
+        for (size_t pos = 0; pos < CAPACITY; pos++)
+            keySlots[pos] = valSlots[pos] = EMPTY;
+
+        for (size_t i = 0; i < N; i++)
+        {
+            size_t keyPos = findKeyPos(pairs[i].first);
+            if (keySlots[keyPos] != EMPTY)
+                throw std::logic_error("Duplicate key in ConstexprBiMap.");
+            keySlots[keyPos] = (Index)i;
+
+            size_t valPos = findValPos(pairs[i].second);
+            if (valSlots[valPos] != EMPTY)
+                throw std::logic_error("Duplicate value in ConstexprBiMap.");
+            valSlots[valPos] = (Index)i;
+        }
+    }
+
+    /**
+     * Find the position for the specified key using quadratic probing.
+     *
+     * @param x The key to find.
+     * @return The position of the key or the first empty position.
+     */
+    constexpr size_t findKeyPos(const KeyType &x) const
+    {
+        size_t offset = 1;
+        size_t currentPos = ConstexprHash<KeyType>()(x) % CAPACITY;
+
+        while (keySlots[currentPos] != EMPTY &&
+               !(pairs[keySlots[currentPos]].first == x))
+        {
+            currentPos += offset; // Compute ith probe
+            offset += 2;
+            if (currentPos >= CAPACITY)
+                currentPos %= CAPACITY;
+        }
+
+        return currentPos;
+    }
+
+    /**
+     * Find the position for the specified value using quadratic probing.
+     *
+     * @param x The value to find.
+     * @return The position of the value or the first empty position.
+     */
+    constexpr size_t findValPos(const ValType &x) const
+    {
+        size_t offset = 1;
+        size_t currentPos = ConstexprHash<ValType>()(x) % CAPACITY;
+
+        while (valSlots[currentPos] != EMPTY &&
+               !(pairs[valSlots[currentPos]].second == x))
+        {
+            currentPos += offset; // Compute ith probe
+            offset += 2;
+            if (currentPos >= CAPACITY)
+                currentPos %= CAPACITY;
+        }
+
+        return currentPos;
+    }
+};
+
+/**
+ * Build a ConstexprBiMap from a braced list of pairs, deducing N.
+ *
+ * @param init The pairs of the map.
+ * @return The map.
+ */
+template <typename KeyType, typename ValType, size_t N>
+constexpr ConstexprBiMap<KeyType, ValType, N>
+makeConstexprBiMap(const pair<KeyType, ValType> (&init)[N])
+{
+    return ConstexprBiMap<KeyType, ValType, N>(init);
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a FrontCache class, a small
+direct-mapped cache of recent lookups that sits in front of a
+hash table. BiMap keeps one per direction for skewed workloads.
+*/
+#ifndef FRONT_CACHE_H
+#define FRONT_CACHE_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+using namespace std;
+
+// Front cache class
+//
+// CONSTRUCTION: disabled (no slots); setSize( ) turns it on
+//
+// Direct-mapped: a key has one slot, and a new key replaces whatever
+// was in its slot. The slots are grouped into 64-byte lines, so a
+// lookup reads one cache line and compares one key.
+//
+// ******************PUBLIC OPERATIONS*********************
+// void setSize( n )          --> Hold about n entries; 0 disables it
+// bool isEnabled( )          --> Return true if it has slots
+// ValType *find( k )         --> Return the cached value of k, or nullptr
+// void store( k, v )         --> Cache the pair <k,v>
+// bool erase( k )            --> Drop k; return true if it was cached
+// void clear( )              --> Drop all entries
+// size_t memoryBytes( )      --> Return the bytes allocated for the lines
+
+template <typename KeyType, typename ValType>
+class FrontCache
+{
+public:
+    FrontCache() : lineBits(0) {}
+
+    /**
+     * Resize the cache, dropping all entries. The number of lines is
+     * rounded up to a power of two.
+     *
+     * @param slots The number of entries to hold; 0 disables the cache.
+     */
+    void setSize(size_t slots)
+    {
+        lines.clear();
+        lineBits = 0;
+        if (slots == 0)
+            return;
+
+        size_t numLines = 2;
+        for (lineBits = 1; numLines * PER_LINE < slots; lineBits++)
+            numLines *= 2;
+        lines.assign(numLines, Line());
+    }
+
+    /**
+     * Check if the cache is on.
+     *
+     * @return True if the cache has slots.
+     */
+    bool isEnabled() const { return !lines.empty(); }
+
+    /**
+     * Look up a key. The cache must be enabled.
+     *
+     * @param x The key to look up.
+     * @return The cached value of x, or nullptr if x is not cached.
+     */
+    const ValType *find(const KeyType &x) const
+    {
+        uint64_t h = mixedHash(x);
+        const Entry &entry = lines[lineOf(h)].entries[entryOf(h)];
+        return entry.valid && entry.key == x ? &entry.value : nullptr;
+    }
+
+    /**
+     * Cache a pair, replacing the entry in its slot.
+     * The cache must be enabled.
+     *
+     * @param x The key.
+     * @param y The value.
+     */
+    void store(const KeyType &x, const ValType &y)
+    {
+        uint64_t h = mixedHash(x);
+        Entry &entry = lines[lineOf(h)].entries[entryOf(h)];
+        entry.key = x;
+        entry.value = y;
+        entry.valid = true;
+    }
+
+    /**
+     * Drop a key from the cache.
+     *
+     * @param x The key to drop.
+     * @return True if x was cached.
+     */
+    bool erase(const KeyType &x)
+    {
+        if (!isEnabled())
+            return false;
+
+        uint64_t h = mixedHash(x);
+        Entry &entry = lines[lineOf(h)].entries[entryOf(h)];
+        if (!entry.valid || !(entry.key == x))
+            return false;
+        entry.valid = false;
+        return true;
+    }
+
+    /**
+     * Drop all entries.
+     */
+    void clear()
+    {
+        for (auto &line : lines)
+            for (auto &entry : line.entries)
+                entry.valid = false;
+    }
+
+    /**
+     * Get the heap memory of the cache.
+     *
+     * @return The bytes allocated for the lines.
+     */
+    size_t memoryBytes() const { return lines.capacity() * sizeof(Line); }
+
+private:
+    /**
+     * A cached pair.
+     */
+    struct Entry
+    {
+        KeyType key;
+        ValType value;
+        bool valid = false; // True if the entry holds a pair
+    };
+
+    // The entries that fit in a 64-byte line (at least one)
+    static const int PER_LINE = sizeof(Entry) >= 64 ? 1 : 64 / sizeof(Entry);
+
+    /**
+     * A cache line of entries.
+     */
+    struct alignas(64) Line
+    {
+        Entry entries[PER_LINE];
+    };
+
+    vector<Line> lines; // The lines; empty if the cache is disabled
+    int lineBits;       // log2 of the number of lines
+
+    /**
+     * Hash a key. The hash is mixed, since std::hash is the
+     * identity for integers.
+     */
+    static uint64_t mixedHash(const KeyType &x)
+    {
+        static hash<KeyType> hf;
+        return (uint64_t)hf(x) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    /**
+     * Get the line of a mixed hash: its top bits.
+     */
+    size_t lineOf(uint64_t h) const { return (size_t)(h >> (64 - lineBits)); }
+
+    /**
+     * Get the entry within the line of a mixed hash.
+     */
+    static int entryOf(uint64_t h) { return (int)((uint32_t)(h >> 16) % PER_LINE); }
+};
+
+#endif
@@ -0,0 +1,436 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a FrozenBiMap class, a read-only
+copy of a BiMap. The pairs are packed densely and indexed in both
+directions by minimal perfect hash functions, so a lookup costs
+one hash, one slot read and one key comparison.
+*/
+#ifndef FROZEN_BI_MAP_H
+#define FROZEN_BI_MAP_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include "BiMap.h"
+using namespace std;
+
+// Minimal perfect hash index
+//
+// CONSTRUCTION: empty; build( ) indexes the hash codes of n objects
+//
+// Maps each of the n objects onto its own slot in [0, n), using the
+// hash-and-displace method: the objects are split into buckets of about
+// four, and each bucket gets a displacement that sends all of its
+// objects to free slots. Buckets are placed largest first; a bucket
+// with one object is sent directly to the next free slot. Slots are
+// 32-bit, so an index holds fewer than 2^32 objects.
+//
+// ******************PUBLIC OPERATIONS*********************
+// void build( hashes, slots ) --> Index the objects with the hash codes
+// size_t getSlot( h )        --> Return the slot of the object with hash h
+// size_t getSize( )          --> Return the number of slots
+// size_t memoryBytes( )      --> Return the bytes used by the index
+
+class PerfectHashIndex
+{
+public:
+    // The slot of an object in an empty index
+    static const size_t NO_SLOT = SIZE_MAX;
+
+    /**
+     * Constructor for an empty index.
+     */
+    PerfectHashIndex() : size(0), salt(0) {}
+
+    /**
+     * Build the index over objects with the given hash codes.
+     *
+     * @param hashes The hash codes of the objects; hashes[i] is object i.
+     * @param slots Set to the slot of each object (slots[i] for object i).
+     * @throws std::runtime_error If two objects have the same hash code.
+     * @throws std::length_error If there are 2^32 or more objects.
+     */
+    void build(const vector<size_t> &hashes, vector<uint32_t> &slots)
+    {
+        if (hashes.size() >= UINT32_MAX)
+            throw length_error("PerfectHashIndex: too many objects");
+
+        size = hashes.size();
+        for (salt = 0; !tryBuild(hashes, slots); ++salt)
+            ;
+    }
+
+    /**
+     * Get the slot of the object with the specified hash code.
+     * An object that was not indexed maps to an arbitrary slot.
+     *
+     * @param h The hash code of the object.
+     * @return The slot of the object, or NO_SLOT if the index is empty.
+     */
+    size_t getSlot(size_t h) const
+    {
+        if (size == 0)
+            return NO_SLOT;
+
+        const Displacement &d = displacements[mix(h, salt) % displacements.size()];
+        return (mix(h, seedOf(d.seed)) % size + d.offset) % size;
+    }
+
+    /**
+     * Get the number of slots, which is the number of objects.
+     *
+     * @return The number of slots.
+     */
+    size_t getSize() const { return size; }
+
+    /**
+     * Get the heap bytes used by the index.
+     *
+     * @return The bytes of the displacement array.
+     */
+    size_t memoryBytes() const
+    {
+        return displacements.capacity() * sizeof(Displacement);
+    }
+
+private:
+    /**
+     * The displacement of one bucket. A slot is
+     * (mix(h, seedOf(seed)) % size + offset) % size; reducing the
+     * hash first keeps the sum from overflowing.
+     */
+    struct Displacement
+    {
+        uint32_t seed;   // Selects the hash function of the bucket
+        uint32_t offset; // Added to the hash, used by one-object buckets
+    };
+
+    // Give up on a salt after this many seeds for one bucket
+    static const uint32_t MAX_SEEDS = 1u << 16;
+
+    size_t size;                        // The number of slots
+    uint64_t salt;                      // Selects the bucket hash function
+    vector<Displacement> displacements; // One displacement per bucket
+
+    /**
+     * Mix a hash code with a seed (the splitmix64 finalizer).
+     *
+     * @param h The hash code.
+     * @param seed The seed.
+     * @return The mixed hash code.
+     */
+    static size_t mix(size_t h, uint64_t seed)
+    {
+        uint64_t x = (uint64_t)h + seed * 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return (size_t)(x ^ (x >> 31));
+    }
+
+    /**
+     * Get the seed of the slot hash function for a bucket seed.
+     */
+    uint64_t seedOf(uint32_t seed) const
+    {
+        return (salt << 32) + seed + 1;
+    }
+
+    /**
+     * Try to build the index with the current salt.
+     *
+     * @param hashes The hash codes of the objects.
+     * @param slots Set to the slot of each object.
+     * @return True if every bucket was placed.
+     */
+    bool tryBuild(const vector<size_t> &hashes, vector<uint32_t> &slots)
+    {
+        size_t numBuckets = size / 4 + 1;
+        displacements.assign(numBuckets, Displacement{0, 0});
+        slots.assign(size, 0);
+
+        // Split the objects into buckets
+        vector<vector<uint32_t>> buckets(numBuckets);
+        for (size_t i = 0; i < size; i++)
+            buckets[mix(hashes[i], salt) % numBuckets].push_back((uint32_t)i);
+
+        // Place the largest buckets first, while most slots are free
+        vector<size_t> order(numBuckets);
+        for (size_t b = 0; b < numBuckets; b++)
+            order[b] = b;
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                    { return buckets[a].size() > buckets[b].size(); });
+
+        vector<bool> taken(size, false);
+        vector<uint32_t> bucketSlots;
+        size_t nextFree = 0; // No free slot below nextFree
+
+        for (size_t b : order)
+        {
+            const vector<uint32_t> &bucket = buckets[b];
+            if (bucket.empty())
+                break;
+
+            if (bucket.size() == 1)
+            {
+                // Send the object straight to the next free slot
+                while (taken[nextFree])
+                    ++nextFree;
+                size_t base = mix(hashes[bucket[0]], seedOf(0)) % size;
+                displacements[b].offset = (uint32_t)((nextFree + size - base) % size);
+                taken[nextFree] = true;
+                slots[bucket[0]] = (uint32_t)nextFree;
+                continue;
+            }
+
+            for (size_t i = 1; i < bucket.size(); i++)
+                for (size_t j = 0; j < i; j++)
+                    if (hashes[bucket[i]] == hashes[bucket[j]])
+                        throw std::runtime_error("Objects with equal hash codes cannot be frozen.");
+
+            uint32_t seed = 0;
+            while (!tryPlace(bucket, hashes, seed, taken, bucketSlots))
+                if (++seed == MAX_SEEDS)
+                    return false;
+
+            displacements[b].seed = seed;
+            for (size_t i = 0; i < bucket.size(); i++)
+            {
+                taken[bucketSlots[i]] = true;
+                slots[bucket[i]] = bucketSlots[i];
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Check whether a seed sends every object of a bucket to its
+     * own free slot.
+     *
+     * @param bucket The objects of the bucket.
+     * @param hashes The hash codes of the objects.
+     * @param seed The seed to try.
+     * @param taken The slots in use.
+     * @param bucketSlots Set to the slots of the bucket's objects.
+     * @return True if the seed works.
+     */
+    bool tryPlace(const vector<uint32_t> &bucket, const vector<size_t> &hashes,
+                  uint32_t seed, const vector<bool> &taken,
+                  vector<uint32_t> &bucketSlots) const
+    {
+        bucketSlots.clear();
+        for (uint32_t i : bucket)
+        {
+            uint32_t slot = (uint32_t)(mix(hashes[i], seedOf(seed)) % size);
+            if (taken[slot] ||
+                find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+                return false;
+            bucketSlots.push_back(slot);
+        }
+        return true;
+    }
+};
+
+// Frozen Bijective Map class
+//
+// CONSTRUCTION: from a BiMap; the FrozenBiMap cannot be modified.
+//
+// ******************PUBLIC OPERATIONS*********************
+// size_t getSize() const     --> Return the number of pairs
+// bool containsKey(x)        --> Return true if x is the key of a pair
+// bool containsVal(x)        --> Return true if x is the value of a pair
+// const ValType getVal(x)    --> Return the value associated with key x
+// const KeyType getKey(x)    --> Return the key associated with value x
+// MemoryUsage memoryUsage()  --> Return the memory used by the map
+
+template <typename KeyType, typename ValType>
+class FrozenBiMap
+{
+public:
+    /**
+     * Constructor
+     *
+     * Copies the pairs of a BiMap and builds the perfect hash
+     * indexes for both directions.
+     *
+     * @param bimap The map to freeze.
+     * @throws std::length_error If it has 2^32 or more pairs.
+     */
+    template <typename Traits>
+    explicit FrozenBiMap(const BiMap<KeyType, ValType, Traits> &bimap)
+    {
+        vector<pair<KeyType, ValType>> unordered;
+        unordered.reserve(bimap.getSize());
+        bimap.forEachPair([&](const KeyType &k, const ValType &v)
+                          { unordered.emplace_back(k, v); });
+
+        vector<size_t> keyHashes(unordered.size());
+        vector<size_t> valHashes(unordered.size());
+        for (size_t i = 0; i < unordered.size(); i++)
+        {
+            keyHashes[i] = hashKey(unordered[i].first);
+            valHashes[i] = hashVal(unordered[i].second);
+        }
+
+        vector<uint32_t> keySlots, valSlots;
+        keyIndex.build(keyHashes, keySlots);
+        valIndex.build(valHashes, valSlots);
+
+        // Pack the pairs in key index order
+        pairs.resize(unordered.size());
+        valPairs.resize(unordered.size());
+        for (size_t i = 0; i < unordered.size(); i++)
+        {
+            pairs[keySlots[i]] = std::move(unordered[i]);
+            valPairs[valSlots[i]] = keySlots[i];
+        }
+    }
+
+    /**
+     * Get the number of key-value pairs in the map.
+     *
+     * @return The number of pairs in the map.
+     */
+    size_t getSize() const { return pairs.size(); }
+
+    /**
+     * Check if the map contains a specific key.
+     *
+     * @param x The key to check.
+     * @return True if the key exists in the map, false otherwise.
+     */
+    bool containsKey(const KeyType &x) const
+    {
+        return findKey(x) != NOT_FOUND;
+    }
+
+    /**
+     * Check if the map contains a specific value.
+     *
+     * @param x The value to check.
+     * @return True if the value exists in the map, false otherwise.
+     */
+    bool containsVal(const ValType &x) const
+    {
+        return findVal(x) != NOT_FOUND;
+    }
+
+    /**
+     * Get the key associated with a specific value.
+     *
+     * @param x The value to look up.
+     * @return The key associated with the value.
+     * @throws std::runtime_error If the value is not found in the map.
+     */
+    const KeyType getKey(const ValType &x) const
+    {
+        size_t pos = findVal(x);
+        if (pos == NOT_FOUND)
+            throw std::runtime_error("Value not found in map.");
+        return pairs[pos].first;
+    }
+
+    /**
+     * Get the value associated with a specific key.
+     *
+     * @param x The key to look up.
+     * @return The value associated with the key.
+     * @throws std::runtime_error If the key is not found in the map.
+     */
+    const ValType getVal(const KeyType &x) const
+    {
+        size_t pos = findKey(x);
+        if (pos == NOT_FOUND)
+            throw std::runtime_error("Key not found in map.");
+        return pairs[pos].second;
+    }
+
+    /**
+     * Report the memory used by the map. Every slot holds a pair; the
+     * perfect hash indexes and the value positions are overhead.
+     *
+     * @return The memory usage of the map.
+     */
+    MemoryUsage memoryUsage() const
+    {
+        static PayloadHeapBytes<KeyType> keyBytes;
+        static PayloadHeapBytes<ValType> valBytes;
+
+        MemoryUsage usage;
+        usage.capacity = usage.activeSlots = pairs.size();
+        usage.overheadBytes = valPairs.capacity() * sizeof(uint32_t) +
+                              keyIndex.memoryBytes() + valIndex.memoryBytes();
+        usage.slotBytes = pairs.capacity() * sizeof(pair<KeyType, ValType>) +
+                          usage.overheadBytes;
+        usage.objectBytes = sizeof(*this);
+        for (auto &p : pairs)
+            usage.payloadHeapBytes += keyBytes(p.first) + valBytes(p.second);
+        return usage;
+    }
+
+private:
+    // The pairs, stored at the slot the key index gives their key
+    vector<pair<KeyType, ValType>> pairs;
+    // For each slot of the value index, the position of its pair
+    vector<uint32_t> valPairs;
+
+    static const size_t NOT_FOUND = SIZE_MAX; // The position of no pair
+
+    PerfectHashIndex keyIndex; // Perfect hash index of the keys
+    PerfectHashIndex valIndex; // Perfect hash index of the values
+
+    /**
+     * Generate the hash code of a key or value.
+     */
+    static size_t hashKey(const KeyType &x)
+    {
+        static hash<KeyType> hf;
+        return hf(x);
+    }
+
+    static size_t hashVal(const ValType &x)
+    {
+        static hash<ValType> hf;
+        return hf(x);
+    }
+
+    /**
+     * Find the position of the pair with the specified key.
+     *
+     * @param x The key to find.
+     * @return The position of the pair, or NOT_FOUND if there is none.
+     */
+    size_t findKey(const KeyType &x) const
+    {
+        size_t pos = keyIndex.getSlot(hashKey(x));
+        return pos != PerfectHashIndex::NO_SLOT && pairs[pos].first == x ? pos : NOT_FOUND;
+    }
+
+    /**
+     * Find the position of the pair with the specified value.
+     *
+     * @param x The value to find.
+     * @return The position of the pair, or NOT_FOUND if there is none.
+     */
+    size_t findVal(const ValType &x) const
+    {
+        size_t slot = valIndex.getSlot(hashVal(x));
+        if (slot == PerfectHashIndex::NO_SLOT)
+            return NOT_FOUND;
+        size_t pos = valPairs[slot];
+        return pairs[pos].second == x ? pos : NOT_FOUND;
+    }
+};
+
+#endif
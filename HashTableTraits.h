@@ -0,0 +1,213 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the traits shared by both HashTable classes.
+The traits select, at compile time, how a slot records whether
+it is EMPTY, ACTIVE or DELETED.
+*/
+#ifndef HASH_TABLE_TRAITS_H
+#define HASH_TABLE_TRAITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "PagedArray.h"
+using namespace std;
+
+// Sentinel policies
+//
+// A sentinel policy reserves two key values to mark EMPTY and DELETED
+// slots, so a slot does not need a separate info field and a probe only
+// compares keys. Keys equal to a sentinel are kept in a side slot.
+//
+// ******************REQUIRED MEMBERS**********************
+// static const bool enabled     --> True if the key encodes the slot state
+// int reservedIndex( k )        --> 0 if k is emptyKey(), 1 if k is
+//                                   deletedKey(), -1 otherwise
+// HashedKey emptyKey( )         --> Key marking an EMPTY slot (if enabled)
+// HashedKey deletedKey( )       --> Key marking a DELETED slot (if enabled)
+
+/**
+ * Sentinel policy for keys that have no spare values.
+ * Every slot keeps an info field.
+ */
+template <typename HashedKey>
+struct NoSentinels
+{
+    static const bool enabled = false;
+
+    static int reservedIndex(const HashedKey &) { return -1; }
+};
+
+/**
+ * Sentinel policy with fixed EMPTY and DELETED key values.
+ * Use it to pick sentinels that never occur in your data, e.g.
+ * FixedSentinels<int, -1, -2> for a table of non-negative IDs.
+ */
+template <typename HashedKey, HashedKey Empty, HashedKey Deleted>
+struct FixedSentinels
+{
+    static_assert(Empty != Deleted, "EMPTY and DELETED sentinels must differ");
+
+    static const bool enabled = true;
+
+    static constexpr HashedKey emptyKey() { return Empty; }
+    static constexpr HashedKey deletedKey() { return Deleted; }
+
+    static int reservedIndex(const HashedKey &x)
+    {
+        return x == Empty ? 0 : (x == Deleted ? 1 : -1);
+    }
+};
+
+/**
+ * Default sentinel policy. Integral keys (other than bool) reserve
+ * their two largest values; all other keys keep an info field.
+ */
+template <typename HashedKey,
+          bool = is_integral<HashedKey>::value &&
+                 !is_same<HashedKey, bool>::value>
+struct SentinelKeys : NoSentinels<HashedKey>
+{
+};
+
+template <typename HashedKey>
+struct SentinelKeys<HashedKey, true>
+    : FixedSentinels<HashedKey,
+                     numeric_limits<HashedKey>::max(),
+                     numeric_limits<HashedKey>::max() - 1>
+{
+};
+
+/**
+ * Holds the (at most two) entries whose key equals a sentinel.
+ * Index 0 is the entry for emptyKey(), index 1 for deletedKey().
+ */
+template <typename HashedVal, bool Enabled>
+class SideSlots
+{
+public:
+    SideSlots() { clearAll(); }
+
+    bool isUsed(int i) const { return used[i]; }
+    const HashedVal &value(int i) const { return values[i]; }
+
+    void set(int i, const HashedVal &v)
+    {
+        values[i] = v;
+        used[i] = true;
+    }
+
+    void set(int i, HashedVal &&v)
+    {
+        values[i] = std::move(v);
+        used[i] = true;
+    }
+
+    void clear(int i) { used[i] = false; }
+    void clearAll() { used[0] = used[1] = false; }
+
+    /**
+     * Call f(key, value) for every used side slot.
+     */
+    template <typename Sentinels, typename Visitor>
+    void forEach(Visitor &f) const
+    {
+        if (used[0])
+            f(Sentinels::emptyKey(), values[0]);
+        if (used[1])
+            f(Sentinels::deletedKey(), values[1]);
+    }
+
+private:
+    bool used[2];        // True if the side slot holds an entry
+    HashedVal values[2]; // The values of the side slot entries
+};
+
+/**
+ * Side slots for tables without sentinels; they are never used.
+ */
+template <typename HashedVal>
+class SideSlots<HashedVal, false>
+{
+public:
+    bool isUsed(int) const { return false; }
+    const HashedVal &value(int) const
+    {
+        static const HashedVal none{};
+        return none;
+    }
+
+    void set(int, const HashedVal &) {}
+    void clear(int) {}
+    void clearAll() {}
+
+    template <typename Sentinels, typename Visitor>
+    void forEach(Visitor &) const {}
+};
+
+/**
+ * Default traits for a HashTable with keys of type HashedKey.
+ *
+ * To configure a table, derive from this struct and override a typedef:
+ *
+ *   struct IdTraits : HashTableTraits<int>
+ *   {
+ *       typedef FixedSentinels<int, -1, -2> Sentinels;
+ *   };
+ *   HashTable<int, IdTraits> ids;
+ *
+ * SizeType is the unsigned type of the capacity, the entry counts and
+ * the slot positions. A table can grow to half the largest SizeType.
+ * Allocator allocates the slot array; see MmapAllocator.h for one
+ * backed by huge pages. SlotArray is the container of the slots.
+ */
+template <typename HashedKey>
+struct HashTableTraits
+{
+    typedef SentinelKeys<HashedKey> Sentinels; // How slots record their state
+    typedef size_t SizeType;                   // Type of sizes and positions
+
+    template <typename T>
+    using Allocator = allocator<T>;            // Allocates the slot array
+
+    template <typename Entry, typename Alloc>
+    using SlotArray = vector<Entry, Alloc>;    // Holds the slots
+};
+
+/**
+ * Traits for a small HashTable, with 32-bit sizes and positions. The
+ * hash is reduced to a slot with a 32-bit division, which is cheaper
+ * than a 64-bit one, and the table is limited to about 2^31 slots.
+ */
+template <typename HashedKey>
+struct CompactHashTableTraits : HashTableTraits<HashedKey>
+{
+    typedef uint32_t SizeType;
+};
+
+/**
+ * Traits for a HashTable whose slots are kept in copy-on-write pages
+ * (see PagedArray). Copying the table, e.g. for a snapshot, costs O(1),
+ * and later writes copy only the pages they touch. Lookups follow one
+ * more pointer. The Allocator is not used.
+ */
+template <typename HashedKey>
+struct CowHashTableTraits : HashTableTraits<HashedKey>
+{
+    template <typename Entry, typename Alloc>
+    using SlotArray = PagedArray<Entry>;
+};
+
+#endif
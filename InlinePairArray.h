@@ -0,0 +1,188 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for an InlinePairArray class, a fixed
+array of up to N key-value pairs searched by a linear scan. A small
+BiMap keeps its pairs in one instead of in two hash tables.
+*/
+#ifndef INLINE_PAIR_ARRAY_H
+#define INLINE_PAIR_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+// Inline pair array class
+//
+// CONSTRUCTION: empty and active
+//
+// The keys and the values are kept in two arrays, so a scan reads
+// only the side it searches. For arithmetic types the scan compares
+// all N slots without branching, which the compiler turns into SIMD
+// compares; other types stop at the first match.
+//
+// ******************PUBLIC OPERATIONS*********************
+// bool isActive( )           --> Return true if it holds the pairs
+// void setActive( b )        --> Start or stop holding the pairs
+// size_t getSize( )          --> Return the number of pairs
+// bool isFull( )             --> Return true if it holds N pairs
+// size_t findKey( k )        --> Return the position of key k, or N
+// size_t findVal( v )        --> Return the position of value v, or N
+// key( i ), value( i )       --> Return the pair at position i
+// void add( k, v )           --> Add the pair <k,v>; it must not be full
+// void removeAt( i )         --> Remove the pair at position i
+// void clear( )              --> Remove all pairs
+
+template <typename KeyType, typename ValType, size_t N>
+class InlinePairArray
+{
+    static_assert(N <= 64, "InlinePairArray holds at most 64 pairs");
+
+public:
+    // The slots start value-initialized, as scan( ) reads unused ones
+    InlinePairArray() : keys{}, values{}, count(0), active(true) {}
+
+    bool isActive() const { return active; }
+    void setActive(bool on) { active = on; }
+    size_t getSize() const { return count; }
+    bool isFull() const { return count == N; }
+
+    const KeyType &key(size_t i) const { return keys[i]; }
+    const ValType &value(size_t i) const { return values[i]; }
+
+    /**
+     * Find the position of a key.
+     *
+     * @param x The key to find.
+     * @return The position of the pair with key x, or N if there is none.
+     */
+    size_t findKey(const KeyType &x) const { return scan(keys, x); }
+
+    /**
+     * Find the position of a value.
+     *
+     * @param x The value to find.
+     * @return The position of the pair with value x, or N if there is none.
+     */
+    size_t findVal(const ValType &x) const { return scan(values, x); }
+
+    /**
+     * Add a pair. The array must not be full.
+     *
+     * @param x The key.
+     * @param y The value.
+     */
+    void add(const KeyType &x, const ValType &y)
+    {
+        keys[count] = x;
+        values[count] = y;
+        ++count;
+    }
+
+    /**
+     * Remove the pair at a position; the last pair takes its place.
+     *
+     * @param i The position.
+     */
+    void removeAt(size_t i)
+    {
+        --count;
+        if (i != count)
+        {
+            keys[i] = std::move(keys[count]);
+            values[i] = std::move(values[count]);
+        }
+        keys[count] = KeyType{};
+        values[count] = ValType{};
+    }
+
+    /**
+     * Remove all pairs.
+     */
+    void clear()
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            keys[i] = KeyType{};
+            values[i] = ValType{};
+        }
+        count = 0;
+    }
+
+private:
+    KeyType keys[N];   // The keys; the first count are in use
+    ValType values[N]; // The values, in the same order as the keys
+    uint8_t count;     // The number of pairs
+    bool active;       // True while the array holds the map's pairs
+
+    /**
+     * Find x among the first count items of an array.
+     *
+     * @param items The array.
+     * @param x The item to find.
+     * @return The position of x, or N if it is not there.
+     */
+    template <typename T>
+    size_t scan(const T (&items)[N], const T &x) const
+    {
+        if constexpr (is_arithmetic<T>::value)
+        {
+            // Compare every slot, then keep the matches in use
+            uint64_t matches = 0;
+            for (size_t i = 0; i < N; i++)
+                matches |= (uint64_t)(items[i] == x) << i;
+            matches &= count == 64 ? ~0ULL : (1ULL << count) - 1;
+            return matches ? (size_t)__builtin_ctzll(matches) : N;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                if (items[i] == x)
+                    return i;
+            return N;
+        }
+    }
+};
+
+/**
+ * An InlinePairArray of no pairs, for maps without a small mode.
+ * It is empty and never active.
+ */
+template <typename KeyType, typename ValType>
+class InlinePairArray<KeyType, ValType, 0>
+{
+public:
+    static constexpr bool isActive() { return false; }
+    void setActive(bool) {}
+    size_t getSize() const { return 0; }
+    bool isFull() const { return true; }
+
+    const KeyType &key(size_t) const { return none<KeyType>(); }
+    const ValType &value(size_t) const { return none<ValType>(); }
+
+    size_t findKey(const KeyType &) const { return 0; }
+    size_t findVal(const ValType &) const { return 0; }
+
+    void add(const KeyType &, const ValType &) {}
+    void removeAt(size_t) {}
+    void clear() {}
+
+private:
+    template <typename T>
+    static const T &none()
+    {
+        static const T value{};
+        return value;
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the MemoryUsage report returned by the hash
+tables and maps, and the PayloadHeapBytes trait used to count the
+heap memory owned by the stored keys and values.
+*/
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
+/**
+ * Heap bytes owned by an object, not counting sizeof(T) itself.
+ * The default is 0; specialize it for types that own heap memory:
+ *
+ *   template <>
+ *   struct PayloadHeapBytes<MyBlob>
+ *   {
+ *       size_t operator()(const MyBlob &b) const { return b.bytes(); }
+ *   };
+ */
+template <typename T>
+struct PayloadHeapBytes
+{
+    size_t operator()(const T &) const { return 0; }
+};
+
+/**
+ * A string owns heap memory only once it outgrows the buffer
+ * inside the string object.
+ */
+template <>
+struct PayloadHeapBytes<string>
+{
+    size_t operator()(const string &s) const
+    {
+        static const size_t inlineCapacity = string().capacity();
+        return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+    }
+};
+
+/**
+ * Memory used by a hash table or map. All fields are totals, so the
+ * reports of several tables can be added together.
+ */
+struct MemoryUsage
+{
+    size_t capacity = 0;         // Number of slots
+    size_t activeSlots = 0;      // Slots holding an entry
+    size_t deletedSlots = 0;     // Slots holding a tombstone
+    size_t slotBytes = 0;        // Bytes allocated for the slot arrays
+    size_t overheadBytes = 0;    // Bytes in slots not used by keys or values
+                                 // (status field, padding, indexes,
+                                 // caches)
+    size_t wastedBytes = 0;      // Bytes of slots holding no entry
+    size_t payloadHeapBytes = 0; // Heap bytes owned by keys and values
+    size_t objectBytes = 0;      // Bytes of the table objects themselves
+    size_t sharedBytes = 0;      // Bytes of the slot arrays shared with
+                                 // copies (copy-on-write pages)
+
+    /**
+     * Get the total number of bytes used.
+     *
+     * @return The bytes of the slot arrays, payloads and objects.
+     */
+    size_t totalBytes() const
+    {
+        return slotBytes + payloadHeapBytes + objectBytes;
+    }
+
+    /**
+     * Get the fraction of slots holding an entry.
+     *
+     * @return The load factor, or 0 if there are no slots.
+     */
+    double loadFactor() const
+    {
+        return capacity == 0 ? 0.0 : (double)activeSlots / capacity;
+    }
+
+    /**
+     * Add the usage of another table to this one.
+     *
+     * @param rhs The usage to add.
+     * @return This usage.
+     */
+    MemoryUsage &operator+=(const MemoryUsage &rhs)
+    {
+        capacity += rhs.capacity;
+        activeSlots += rhs.activeSlots;
+        deletedSlots += rhs.deletedSlots;
+        slotBytes += rhs.slotBytes;
+        overheadBytes += rhs.overheadBytes;
+        wastedBytes += rhs.wastedBytes;
+        payloadHeapBytes += rhs.payloadHeapBytes;
+        objectBytes += rhs.objectBytes;
+        sharedBytes += rhs.sharedBytes;
+        return *this;
+    }
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for an MmapAllocator class, which
+allocates the slot arrays of very large hash tables straight from
+the OS with mmap, backed by transparent huge pages. Linux only.
+*/
+#ifndef MMAP_ALLOCATOR_H
+#define MMAP_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+using namespace std;
+
+// Mmap allocator class
+//
+// CONSTRUCTION: stateless; all MmapAllocators are interchangeable
+//
+// An allocation of at least HUGE_PAGE bytes gets its own mapping,
+// aligned to a 2MB huge page and marked MADV_HUGEPAGE, so a random
+// probe touches one TLB entry per 2MB instead of per 4KB. Freeing it
+// unmaps it, which gives the memory straight back to the OS. Smaller
+// allocations use operator new, as a mapping would waste most of a page.
+//
+// With Populate, every page is faulted in up front, in one pass by the
+// kernel, rather than one page fault per page on first touch. It is
+// done after the huge page advice, which MAP_POPULATE would come too
+// early for, so the pages are huge pages.
+//
+// Select it per table through the traits:
+//
+//   struct BigTraits : HashTableTraits<long>
+//   {
+//       template <typename T>
+//       using Allocator = MmapAllocator<T>;
+//   };
+//   HashTable<long, BigTraits> big(1 << 28);
+//
+// ******************PUBLIC OPERATIONS*********************
+// T *allocate( n )           --> Allocate an array of n Ts
+// void deallocate( p, n )    --> Free an array from allocate( n )
+
+template <typename T, bool Populate = false>
+class MmapAllocator
+{
+public:
+    typedef T value_type;
+
+    // The size of a transparent huge page on x86-64 and ARM64
+    static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef MmapAllocator<U, Populate> other;
+    };
+
+    MmapAllocator() {}
+
+    template <typename U>
+    MmapAllocator(const MmapAllocator<U, Populate> &) {}
+
+    /**
+     * Allocate an uninitialized array.
+     *
+     * @param n The number of elements.
+     * @return The array.
+     * @throws std::bad_alloc If the memory cannot be mapped.
+     */
+    T *allocate(size_t n)
+    {
+        if (n > (SIZE_MAX - 2 * HUGE_PAGE) / sizeof(T))
+            throw bad_alloc();
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE)
+            return static_cast<T *>(::operator new(bytes));
+
+        // Map an extra huge page, then trim both ends so the array
+        // starts on a huge page boundary
+        size_t length = roundUp(bytes);
+        void *p = mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw bad_alloc();
+
+        uintptr_t start = (uintptr_t)p;
+        uintptr_t aligned = (start + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1);
+        if (aligned > start)
+            munmap(p, aligned - start);
+        munmap((void *)(aligned + length), start + HUGE_PAGE - aligned);
+
+        // Only a hint: without transparent huge pages it does nothing
+        madvise((void *)aligned, length, MADV_HUGEPAGE);
+        if (Populate)
+            prefault((char *)aligned, length);
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    /**
+     * Free an array from allocate( ), giving a mapping back to the OS.
+     *
+     * @param p The array.
+     * @param n The number of elements it was allocated with.
+     */
+    void deallocate(T *p, size_t n)
+    {
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE)
+            ::operator delete(p);
+        else
+            munmap(p, roundUp(bytes));
+    }
+
+private:
+    /**
+     * Round a length up to a whole number of huge pages.
+     */
+    static size_t roundUp(size_t bytes)
+    {
+        return (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    }
+
+    /**
+     * Fault in every page of a mapping.
+     */
+    static void prefault(char *p, size_t length)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(p, length, MADV_POPULATE_WRITE) == 0)
+            return;
+#endif
+        // Older kernels: write to every 4KB page; the memory is
+        // zero already, so writing zero changes nothing
+        for (size_t i = 0; i < length; i += 4096)
+            p[i] = 0;
+    }
+};
+
+template <typename T, typename U, bool Populate>
+bool operator==(const MmapAllocator<T, Populate> &, const MmapAllocator<U, Populate> &)
+{
+    return true;
+}
+
+template <typename T, typename U, bool Populate>
+bool operator!=(const MmapAllocator<T, Populate> &, const MmapAllocator<U, Populate> &)
+{
+    return false;
+}
+
+#endif
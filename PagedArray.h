@@ -0,0 +1,206 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for a PagedArray class, a fixed-size
+array split into reference-counted pages, so copies of it share
+their pages and a page is copied only when one side writes to it.
+*/
+#ifndef PAGED_ARRAY_H
+#define PAGED_ARRAY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+using namespace std;
+
+// Paged copy-on-write array class
+//
+// CONSTRUCTION: with a size; every element is value-initialized
+//
+// The elements are kept in pages of about PAGE_BYTES. A directory
+// points at the pages, and the array points at the directory, so a
+// copy shares everything and costs O(1). The first write through a
+// copy copies the directory (a pointer per page), and each write to a
+// page still shared with another copy copies that page. Const access
+// never copies.
+//
+// One thread may write to an array while other threads read copies of
+// it: the writer never changes memory that a copy can still see.
+//
+// ******************PUBLIC OPERATIONS*********************
+// size_t size( )             --> Return the number of elements
+// bool empty( )              --> Return true if there are none
+// size_t capacity( )         --> Return the elements the pages hold
+// T &operator[]( i )         --> Return element i, copying its page
+//                                first if it is shared
+// const T &operator[]( i )   --> Return element i
+// size_t sharedBytes( )      --> Return the bytes of pages shared
+//                                with other copies
+// void swap( rhs )           --> Swap contents with rhs
+// begin( ), end( )           --> Iterate over the elements
+
+/**
+ * Get the largest power of two <= n, for n > 0.
+ */
+constexpr size_t floorPowerOfTwo(size_t n)
+{
+    return n < 2 ? 1 : 2 * floorPowerOfTwo(n / 2);
+}
+
+template <typename T>
+class PagedArray
+{
+public:
+    typedef T value_type;
+
+    // The target size of a page in bytes
+    static const size_t PAGE_BYTES = 64 * 1024;
+
+    // The elements per page: the largest power of two that fits
+    static const size_t PER_PAGE =
+        floorPowerOfTwo(sizeof(T) >= PAGE_BYTES ? 1 : PAGE_BYTES / sizeof(T));
+
+    /**
+     * An iterator over the elements by position.
+     */
+    template <typename Array, typename Ref>
+    class IndexIterator
+    {
+    public:
+        IndexIterator(Array *a, size_t i) : a(a), i(i) {}
+
+        Ref operator*() const { return (*a)[i]; }
+
+        IndexIterator &operator++()
+        {
+            ++i;
+            return *this;
+        }
+
+        bool operator!=(const IndexIterator &rhs) const { return i != rhs.i; }
+
+    private:
+        Array *a; // The array
+        size_t i; // The position
+    };
+
+    typedef IndexIterator<PagedArray, T &> iterator;
+    typedef IndexIterator<const PagedArray, const T &> const_iterator;
+
+    /**
+     * Constructor for an array of n value-initialized elements.
+     *
+     * @param n The number of elements (default: 0).
+     */
+    explicit PagedArray(size_t n = 0)
+        : numElements(n), directory(make_shared<Directory>())
+    {
+        size_t pages = (n + PER_PAGE - 1) / PER_PAGE;
+        directory->reserve(pages);
+        for (size_t p = 0; p < pages; p++)
+            directory->push_back(make_shared<Page>());
+    }
+
+    size_t size() const { return numElements; }
+    bool empty() const { return numElements == 0; }
+    size_t capacity() const { return directory->size() * PER_PAGE; }
+    size_t max_size() const { return Directory().max_size() / sizeof(Page) * PER_PAGE; }
+
+    const T &operator[](size_t i) const
+    {
+        return (*directory)[i / PER_PAGE]->elements[i % PER_PAGE];
+    }
+
+    T &operator[](size_t i)
+    {
+        return writablePage(i / PER_PAGE).elements[i % PER_PAGE];
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, numElements); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, numElements); }
+
+    /**
+     * Get the bytes of the pages that another copy also uses.
+     *
+     * @return The bytes of the shared pages.
+     */
+    size_t sharedBytes() const
+    {
+        size_t pages = 0;
+        for (auto &page : *directory)
+            if (directory.use_count() > 1 || page.use_count() > 1)
+                ++pages;
+        return pages * sizeof(Page);
+    }
+
+    void swap(PagedArray &rhs)
+    {
+        std::swap(numElements, rhs.numElements);
+        directory.swap(rhs.directory);
+    }
+
+private:
+    /**
+     * A page of elements.
+     */
+    struct Page
+    {
+        T elements[PER_PAGE];
+    };
+
+    typedef vector<shared_ptr<Page>> Directory;
+
+    size_t numElements;              // The number of elements
+    shared_ptr<Directory> directory; // The pages; shared with copies
+
+    /**
+     * Get a page to write to, first copying the directory and the
+     * page if another copy shares them.
+     *
+     * @param p The page number.
+     * @return The page, owned by this array alone.
+     */
+    Page &writablePage(size_t p)
+    {
+        if (directory.use_count() > 1)
+            directory = make_shared<Directory>(*directory);
+
+        shared_ptr<Page> &page = (*directory)[p];
+        if (page.use_count() > 1)
+            page = make_shared<Page>(*page);
+
+        // A count of 1 may come from another thread dropping its
+        // copy; its reads must finish before our writes start
+        atomic_thread_fence(memory_order_acquire);
+        return *page;
+    }
+};
+
+/**
+ * Get the bytes of a slot array shared with other copies of it.
+ * Only a PagedArray shares memory.
+ */
+template <typename Array>
+size_t sharedSlotBytes(const Array &)
+{
+    return 0;
+}
+
+template <typename T>
+size_t sharedSlotBytes(const PagedArray<T> &array)
+{
+    return array.sharedBytes();
+}
+
+#endif
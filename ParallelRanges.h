@@ -0,0 +1,99 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file contains the code for parallelRanges, which splits a range
+of positions, e.g. the slots of a hash table, across threads.
+*/
+#ifndef PARALLEL_RANGES_H
+#define PARALLEL_RANGES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Parallel ranges
+//
+// parallelRanges( n, threads, f ) splits [0, n) into one contiguous
+// range per thread and calls f( t, lo, hi ) for range t on thread t.
+// The calling thread runs range 0 and waits for the others. An
+// exception thrown by f on any thread is rethrown by parallelRanges.
+//
+// ******************PUBLIC OPERATIONS*********************
+// unsigned rangeThreads( n, requested ) --> Return the threads to use
+//                                for n positions
+// void parallelRanges( n, threads, f ) --> Call f on each range of [0, n)
+
+// The fewest positions worth a thread of their own
+const size_t MIN_RANGE = 1 << 16;
+
+/**
+ * Get the number of threads to split n positions across.
+ *
+ * @param n The number of positions.
+ * @param requested The threads asked for; 0 for one per core.
+ * @return At least 1, and at most one thread per MIN_RANGE positions.
+ */
+inline unsigned rangeThreads(size_t n, unsigned requested)
+{
+    if (requested == 0)
+        requested = max(1u, thread::hardware_concurrency());
+    return (unsigned)max<size_t>(1, min<size_t>(requested, n / MIN_RANGE));
+}
+
+/**
+ * Call f( t, lo, hi ) on each of threads ranges of [0, n), in parallel.
+ *
+ * @param n The number of positions.
+ * @param threads The number of ranges and threads, at least 1.
+ * @param f The work for one range.
+ */
+template <typename Work>
+void parallelRanges(size_t n, unsigned threads, Work f)
+{
+    vector<exception_ptr> errors(threads);
+    auto run = [&](unsigned t)
+    {
+        try
+        {
+            f(t, n / threads * t + min<size_t>(t, n % threads),
+              n / threads * (t + 1) + min<size_t>(t + 1, n % threads));
+        }
+        catch (...)
+        {
+            errors[t] = current_exception();
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        try
+        {
+            workers.emplace_back(run, t);
+        }
+        catch (const system_error &)
+        {
+            run(t); // No thread to spare: run the range here
+        }
+    }
+    run(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    for (auto &error : errors)
+        if (error)
+            rethrow_exception(error);
+}
+
+#endif
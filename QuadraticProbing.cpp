@@ -13,13 +13,16 @@ and determining prime numbers, which are used in
 resizing a hash table.
 */
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 using namespace std;
 
 /**
  * Internal method to test if a positive number is prime.
  * Not an efficient algorithm.
  */
-bool isPrime( int n )
+bool isPrime( size_t n )
 {
     if( n == 2 || n == 3 )
         return true;
@@ -27,7 +30,8 @@ bool isPrime( int n )
     if( n == 1 || n % 2 == 0 )
         return false;
 
-    for( int i = 3; i * i <= n; i += 2 )
+    // i <= n / i rather than i * i <= n, which overflows near SIZE_MAX
+    for( size_t i = 3; i <= n / i; i += 2 )
         if( n % i == 0 )
             return false;
 
@@ -37,14 +41,16 @@ bool isPrime( int n )
 /**
  * Internal method to return a prime number at least as large as n.
  * Assumes n > 0.
+ * Throws length_error if there is no such prime below SIZE_MAX.
  */
-int nextPrime( int n )
+size_t nextPrime( size_t n )
 {
     if( n % 2 == 0 )
         ++n;
 
     for( ; !isPrime( n ); n += 2 )
-        ;
+        if( n > SIZE_MAX - 2 )
+            throw length_error( "nextPrime: no prime fits in size_t" );
 
     return n;
 }
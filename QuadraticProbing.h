@@ -19,7 +19,14 @@ of key-value pairs.
 #include <algorithm>
 #include <functional>
 #include <string>
-#include "QuadraticProbing.cpp"
+#include <limits>
+#include <stdexcept>
+#include <atomic>
+#include "HashTableTraits.h"
+#include "BatchProbe.h"
+#include "ParallelRanges.h"
+#include "MemoryUsage.h"
+#include "dsexceptions.h"
 
 using namespace std;
 
@@ -30,20 +37,45 @@ using namespace std;
  * @param n The minimum size of the hash table.
  * @return A prime number >= n.
  */
-int nextPrime(int n);
+size_t nextPrime(size_t n);
 
 // QuadraticProbing Hash table class
 //
 // CONSTRUCTION: an approximate initial size or default of 101
 //
+// Traits::SizeType is the type of sizes and positions: size_t by
+// default, or uint32_t with CompactHashTableTraits. Growing the array
+// past half the largest SizeType throws std::length_error.
+// Traits::Allocator allocates the array, e.g. MmapAllocator for huge
+// pages, and Traits::SlotArray holds it, e.g. in copy-on-write pages.
+//
+// Traits::Sentinels selects the slot layout. With sentinels (the default
+// for integral objs) a slot holds only the obj, and the state is encoded
+// in it; objs equal to a sentinel go to a side slot.
+//
+// The set operations scan the smaller table, split by slot range
+// across t threads (0, the default, for one per core), and look each
+// obj up in the larger one. The result is sized for its objs before
+// they go in. For integral objs with sentinels in a vector, all the
+// threads insert into it at once; otherwise one thread does.
+//
 // ******************PUBLIC OPERATIONS*********************
 // bool insert( x )       --> Insert x
 // bool remove( x )       --> Remove x
 // bool contains( x )     --> Return true if x is present
+// void containsBatch( xs, n, found ) --> Set found[i] to contains( xs[i] )
+// size_t getSize( )      --> Return the number of objs
+// HashTable intersect( rhs, t ) --> Return the objs in both tables
+// HashTable unite( rhs, t ) --> Return the objs in either table
+// HashTable subtract( rhs, t ) --> Return the objs not in rhs
+// bool isSubset( rhs, t ) --> Return true if every obj is in rhs
 // void makeEmpty( )      --> Remove all items
+// void setShrinkThreshold( f ) --> Shrink when the live load falls below f
+// void shrinkToFit( )    --> Shrink the table to fit its items
+// MemoryUsage memoryUsage( ) --> Return the memory used by the table
 // int hashCode( string str ) --> Global method to hash strings
 
-template <typename HashedObj>
+template <typename HashedObj, typename Traits = HashTableTraits<HashedObj>>
 class HashTable
 {
 public:
@@ -55,8 +87,10 @@ public:
      * the default size is 101.
      *
      * @param size The initial size of the hash table (default: 101).
+     * @throws std::length_error If size is above the largest capacity.
      */
-    explicit HashTable(int size = 101) : array(nextPrime(size))
+    explicit HashTable(size_t size = 101)
+        : array(capacityFor(size)), minCapacity((SizeType)array.size())
     {
         makeEmpty();
     }
@@ -69,17 +103,221 @@ public:
      */
     bool contains(const HashedObj &x) const
     {
+        // Objs equal to a sentinel live in a side slot
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+            return sideSlots.isUsed(side);
+
         return isActive(findPos(x));
     }
 
+    /**
+     * Check a batch of objs. A HashTable<int> with sentinels in a
+     * vector checks 8 objs at a time with AVX2 (see BatchProbe.h);
+     * other tables call contains( ) for each obj.
+     *
+     * @param xs The objs to check.
+     * @param n The number of objs.
+     * @param found Set found[i] to true iff xs[i] is present.
+     */
+    void containsBatch(const HashedObj *xs, size_t n, bool *found) const
+    {
+        auto probe = [this](const HashedObj &x) { return contains(x); };
+        if constexpr (BATCH_KERNEL) // The key is the first member of an entry
+            batchContains<sizeof(HashEntry)>((const int *)array.data(), array.size(),
+                                             Sentinels::emptyKey(), Sentinels::deletedKey(),
+                                             xs, n, found, probe);
+        else
+            for (size_t i = 0; i < n; i++)
+                found[i] = probe(xs[i]);
+    }
+
+    /**
+     * Get the number of objs in the table.
+     *
+     * @return The number of objs.
+     */
+    size_t getSize() const
+    {
+        return activeSize + sideSlots.isUsed(0) + sideSlots.isUsed(1);
+    }
+
+    /**
+     * Get the objs in both this table and rhs.
+     *
+     * @param rhs The other table.
+     * @param threads The number of threads; 0 for one per core.
+     * @return A new table of the objs in both.
+     */
+    HashTable intersect(const HashTable &rhs, unsigned threads = 0) const
+    {
+        const HashTable &small = getSize() <= rhs.getSize() ? *this : rhs;
+        const HashTable &large = &small == this ? rhs : *this;
+        auto parts = small.collect(threads, [&](SizeType, const HashedObj &x)
+                                   { return large.contains(x); });
+
+        HashTable result = fromParts(parts, nullptr, threads);
+        for (int side = 0; side < 2; side++)
+            if (sideSlots.isUsed(side) && rhs.sideSlots.isUsed(side))
+                result.sideSlots.set(side, true);
+        return result;
+    }
+
+    /**
+     * Get the objs in this table, rhs, or both. The objs of the
+     * smaller table that the larger one lacks are added to a copy of
+     * the larger one.
+     *
+     * @param rhs The other table.
+     * @param threads The number of threads; 0 for one per core.
+     * @return A new table of the objs in either.
+     */
+    HashTable unite(const HashTable &rhs, unsigned threads = 0) const
+    {
+        const HashTable &small = getSize() <= rhs.getSize() ? *this : rhs;
+        const HashTable &large = &small == this ? rhs : *this;
+        auto parts = small.collect(threads, [&](SizeType, const HashedObj &x)
+                                   { return !large.contains(x); });
+
+        HashTable result = fromParts(parts, &large, threads);
+        for (int side = 0; side < 2; side++)
+            if (sideSlots.isUsed(side) || rhs.sideSlots.isUsed(side))
+                result.sideSlots.set(side, true);
+        return result;
+    }
+
+    /**
+     * Get the objs in this table that are not in rhs. If rhs is the
+     * smaller table, its objs are looked up here to mark the slots to
+     * leave out.
+     *
+     * @param rhs The other table.
+     * @param threads The number of threads; 0 for one per core.
+     * @return A new table of the objs only in this one.
+     */
+    HashTable subtract(const HashTable &rhs, unsigned threads = 0) const
+    {
+        vector<vector<HashedObj>> parts;
+        if (getSize() <= rhs.getSize())
+            parts = collect(threads, [&](SizeType, const HashedObj &x)
+                            { return !rhs.contains(x); });
+        else
+        {
+            // Each obj has one slot, so no two threads mark the same one
+            vector<unsigned char> inRhs(array.size(), 0);
+            rhs.parallelForEach(threads, [&](unsigned, SizeType, const HashedObj &x)
+                                {
+                                    SizeType currentPos = findPos(x);
+                                    if (isActive(currentPos))
+                                        inRhs[currentPos] = 1;
+                                });
+            parts = collect(threads, [&](SizeType currentPos, const HashedObj &)
+                            { return !inRhs[currentPos]; });
+        }
+
+        HashTable result = fromParts(parts, nullptr, threads);
+        for (int side = 0; side < 2; side++)
+            if (sideSlots.isUsed(side) && !rhs.sideSlots.isUsed(side))
+                result.sideSlots.set(side, true);
+        return result;
+    }
+
+    /**
+     * Check if every obj in this table is also in rhs. The threads
+     * stop looking objs up once one of them finds an obj rhs lacks.
+     *
+     * @param rhs The other table.
+     * @param threads The number of threads; 0 for one per core.
+     * @return True if this table is a subset of rhs.
+     */
+    bool isSubset(const HashTable &rhs, unsigned threads = 0) const
+    {
+        if (getSize() > rhs.getSize())
+            return false;
+        for (int side = 0; side < 2; side++)
+            if (sideSlots.isUsed(side) && !rhs.sideSlots.isUsed(side))
+                return false;
+
+        atomic<bool> missing(false);
+        parallelForEach(threads, [&](unsigned, SizeType, const HashedObj &x)
+                        {
+                            if (!missing.load(memory_order_relaxed) && !rhs.contains(x))
+                                missing.store(true, memory_order_relaxed);
+                        });
+        return !missing.load();
+    }
+
+    /**
+     * Report the memory used by the hash table. Walks every slot.
+     *
+     * @return The memory usage of the table.
+     */
+    MemoryUsage memoryUsage() const
+    {
+        static PayloadHeapBytes<HashedObj> objBytes;
+
+        MemoryUsage usage;
+        usage.capacity = array.size();
+        usage.slotBytes = array.capacity() * sizeof(HashEntry);
+        usage.objectBytes = sizeof(*this);
+        usage.sharedBytes = sharedSlotBytes(array);
+        for (auto &entry : array)
+        {
+            if (entry.isActive())
+            {
+                ++usage.activeSlots;
+                usage.payloadHeapBytes += objBytes(entry.element);
+            }
+            else if (entry.isDeleted())
+                ++usage.deletedSlots;
+        }
+
+        usage.overheadBytes = usage.capacity * (sizeof(HashEntry) - sizeof(HashedObj));
+        usage.wastedBytes = (usage.capacity - usage.activeSlots) * sizeof(HashEntry);
+        return usage;
+    }
+
+    /**
+     * Set the live load below which remove( ) shrinks the table.
+     * A shrink leaves the table a quarter full, so it takes many
+     * more removals, or a doubling of the entries, before the next
+     * resize. The table never shrinks below its initial size.
+     *
+     * @param fraction The shrink threshold in [0, 0.25); 0 turns it off.
+     * @throws IllegalArgumentException If fraction is out of range.
+     */
+    void setShrinkThreshold(double fraction)
+    {
+        if (fraction < 0 || fraction >= 0.25)
+            throw IllegalArgumentException{};
+        shrinkLoad = fraction;
+    }
+
+    /**
+     * Shrink the table to the smallest size that holds its
+     * entries, clearing out all DELETED entries.
+     */
+    void shrinkToFit()
+    {
+        rehash(capacityFor(max<size_t>(2 * (size_t)activeSize + 1, 3)));
+    }
+
     /**
      * Remove all objs from the hash table.
      */
     void makeEmpty()
     {
         currentSize = 0;
-        for (auto &entry : array)
-            entry.info = EMPTY;
+        activeSize = 0;
+
+        // Give back the memory of a table that has grown, or of one
+        // whose pages another copy shares, rather than copy them to clear
+        if (array.size() > minCapacity || sharedSlotBytes(array) != 0)
+            EntryArray(minCapacity).swap(array);
+        else
+            for (auto &entry : array)
+                entry.markEmpty();
+        sideSlots.clearAll();
     }
 
     /**
@@ -90,23 +328,33 @@ public:
      */
     bool insert(const HashedObj &x)
     {
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (sideSlots.isUsed(side))
+                return false;
+            sideSlots.set(side, true);
+            return true;
+        }
+
         // Insert x as active
-        int currentPos = findPos(x);
+        SizeType currentPos = findPos(x);
         if (isActive(currentPos))
             return false;
 
         // If the position is already occupied by active element,
         // this mean the hash table is full.
-        if (array[currentPos].info != DELETED)
+        if (!array[currentPos].isDeleted())
             ++currentSize;
 
         // If the position is not maked as DELETED or ACTIVE,
         // meaning the position is EMPTY and is available to insertion.
         array[currentPos].element = x;
-        array[currentPos].info = ACTIVE;
+        array[currentPos].markActive();
+        ++activeSize;
 
         // Rehash; see Section 5.5
-        if (currentSize > (int)array.size() / 2)
+        if (currentSize > array.size() / 2)
             rehash();
 
         return true;
@@ -120,8 +368,17 @@ public:
      */
     bool insert(HashedObj &&x)
     {
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (sideSlots.isUsed(side))
+                return false;
+            sideSlots.set(side, true);
+            return true;
+        }
+
         // Insert x as active
-        int currentPos = findPos(x);
+        SizeType currentPos = findPos(x);
 
         // If the position is already occupied by active element,
         // this mean the hash table is full.
@@ -130,15 +387,16 @@ public:
 
         // If the position is not maked as DELETED or ACTIVE,
         // meaning the position is EMPTY and is available to insertion.
-        if (array[currentPos].info != DELETED)
+        if (!array[currentPos].isDeleted())
             ++currentSize;
 
         // Use move semantics to avoid expensive copying
-        array[currentPos] = std::move(x);
-        array[currentPos].info = ACTIVE;
+        array[currentPos].element = std::move(x);
+        array[currentPos].markActive();
+        ++activeSize;
 
         // Rehash; see Section 5.5
-        if (currentSize > (int)array.size() / 2)
+        if (currentSize > array.size() / 2)
             rehash();
 
         return true;
@@ -152,11 +410,25 @@ public:
      */
     bool remove(const HashedObj &x)
     {
-        int currentPos = findPos(x);
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (!sideSlots.isUsed(side))
+                return false;
+            sideSlots.clear(side);
+            return true;
+        }
+
+        SizeType currentPos = findPos(x);
         if (!isActive(currentPos))
             return false;
 
-        array[currentPos].info = DELETED;
+        array[currentPos].markDeleted();
+        --activeSize;
+
+        // Shrink once the table is mostly empty
+        if (activeSize < shrinkLoad * array.size() && array.size() > minCapacity)
+            rehash(capacityFor(max<size_t>(4 * (size_t)activeSize, minCapacity)));
         return true;
     }
 
@@ -171,11 +443,15 @@ public:
     };
 
 private:
+    typedef typename Traits::Sentinels Sentinels;
+    typedef typename Traits::SizeType SizeType; // Type of sizes and positions
+
     /**
      * Represents an entry in the hash table,
-     * storing a key, value, and status.
+     * storing an obj and its status.
      */
-    struct HashEntry
+    template <bool Packed, typename Unused = void>
+    struct Entry
     {
         HashedObj element;
         EntryType info;
@@ -186,7 +462,7 @@ private:
          * @param e The object to store (default: default-constructed HashedObj).
          * @param i The status of the entry (default: EMPTY).
          */
-        HashEntry(const HashedObj &e = HashedObj{}, EntryType i = EMPTY)
+        Entry(const HashedObj &e = HashedObj{}, EntryType i = EMPTY)
             : element{e}, info{i} {}
 
         /**
@@ -195,12 +471,71 @@ private:
          * @param e The object to store (rvalue reference).
          * @param i The status of the entry (default: EMPTY).
          */
-        HashEntry(HashedObj &&e, EntryType i = EMPTY)
+        Entry(HashedObj &&e, EntryType i = EMPTY)
             : element{std::move(e)}, info{i} {}
+
+        bool isActive() const { return info == ACTIVE; }
+        bool isEmpty() const { return info == EMPTY; }
+        bool isDeleted() const { return info == DELETED; }
+
+        void markActive() { info = ACTIVE; }
+        void markEmpty() { info = EMPTY; }
+        void markDeleted() { info = DELETED; }
     };
 
-    vector<HashEntry> array; // Array that holds the HashEntries
-    int currentSize;         // The current size of the array
+    /**
+     * Represents an entry in a hash table with sentinels,
+     * storing only the obj. EMPTY and DELETED are sentinel objs.
+     */
+    template <typename Unused>
+    struct Entry<true, Unused>
+    {
+        HashedObj element; // The obj being stored, or a sentinel
+
+        /**
+         * Constructor for an EMPTY entry.
+         */
+        Entry() : element{Sentinels::emptyKey()} {}
+
+        bool isActive() const
+        {
+            return element != Sentinels::emptyKey() &&
+                   element != Sentinels::deletedKey();
+        }
+        bool isEmpty() const { return element == Sentinels::emptyKey(); }
+        bool isDeleted() const { return element == Sentinels::deletedKey(); }
+
+        void markActive() {}
+        void markEmpty() { element = Sentinels::emptyKey(); }
+        void markDeleted() { element = Sentinels::deletedKey(); }
+    };
+
+    typedef Entry<Sentinels::enabled> HashEntry;
+    typedef typename Traits::template SlotArray<
+        HashEntry, typename Traits::template Allocator<HashEntry>> EntryArray;
+
+    // True if the slots are one contiguous vector
+    static constexpr bool CONTIGUOUS_SLOTS =
+        is_same<EntryArray, vector<HashEntry, typename Traits::template Allocator<HashEntry>>>::value;
+
+    // True if threads can insert at once: integral objs alone in
+    // their slots, which an atomic compare-and-swap can claim
+    static constexpr bool CONCURRENT_INSERT =
+        is_integral<HashedObj>::value && Sentinels::enabled && CONTIGUOUS_SLOTS;
+
+    // True if containsBatch( ) can use the batch kernel: int objs
+    // alone in their slots, in one contiguous array
+    static constexpr bool BATCH_KERNEL =
+        is_same<HashedObj, int>::value && Sentinels::enabled && CONTIGUOUS_SLOTS;
+
+    EntryArray array;        // Array that holds the HashEntries
+    SizeType currentSize;    // The number of ACTIVE and DELETED entries
+    SizeType activeSize;     // The number of ACTIVE entries
+    SizeType minCapacity;    // The initial size, the smallest after a shrink
+    double shrinkLoad = 0.125; // Shrink when activeSize falls below this load
+
+    // Objs that are sentinels; the stored value is unused
+    SideSlots<bool, Sentinels::enabled> sideSlots;
 
     /**
      * Check if the entry at the specified position is active.
@@ -208,9 +543,9 @@ private:
      * @param currentPos The position to check.
      * @return True if the entry is active, false otherwise.
      */
-    bool isActive(int currentPos) const
+    bool isActive(SizeType currentPos) const
     {
-        return array[currentPos].info == ACTIVE;
+        return array[currentPos].isActive();
     }
 
     /**
@@ -219,43 +554,186 @@ private:
      * @param x The OBJ to find.
      * @return The position of the OBJ or the first empty position.
      */
-    int findPos(const HashedObj &x) const
+    SizeType findPos(const HashedObj &x) const
     {
-        int offset = 1;             // Offset value for hash(x)
-        int currentPos = myhash(x); // Returns the initial hash index
+        // The table is at most half full, so a free slot turns up
+        // within array.size() / 2 probes: offset stays below
+        // array.size(), and one subtraction wraps currentPos. As
+        // array.size() is at most half the largest SizeType,
+        // currentPos + offset cannot overflow.
+        SizeType offset = 1;        // Offset value for hash(x)
+        SizeType currentPos = myhash(x); // Returns the initial hash index
 
         // Stop searching if current position is
         // EMPTY or the element is found.
-        while (array[currentPos].info != EMPTY &&
+        while (!array[currentPos].isEmpty() &&
                array[currentPos].element != x)
         {
             currentPos += offset; // Compute ith probe
             offset += 2;
             // same effect as mod array.size()
-            if (currentPos >= (int)array.size())
-                currentPos -= (int)array.size();
+            if (currentPos >= array.size())
+                currentPos -= (SizeType)array.size();
         }
 
         return currentPos;
     }
 
     /**
-     * Resize the hash table to a larger size and rehash all active entries.
+     * Call f( t, currentPos, x ) for every obj x in the array, where
+     * currentPos is its slot and t the thread. Each thread scans its
+     * own range of slots, so f must be safe to call from several
+     * threads at once.
+     *
+     * @param threads The number of threads; 0 for one per core.
+     * @param f The visitor.
+     */
+    template <typename Visitor>
+    void parallelForEach(unsigned threads, Visitor f) const
+    {
+        parallelRanges(array.size(), rangeThreads(array.size(), threads), [&](unsigned t, size_t lo, size_t hi)
+                       {
+                           for (size_t i = lo; i < hi; i++)
+                               if (isActive((SizeType)i))
+                                   f(t, (SizeType)i, array[i].element);
+                       });
+    }
+
+    /**
+     * Collect the objs in the array that keep( currentPos, x ) picks.
+     *
+     * @param threads The number of threads; 0 for one per core.
+     * @param keep The test for an obj; see parallelForEach( ).
+     * @return The objs picked, one vector per thread.
+     */
+    template <typename Keep>
+    vector<vector<HashedObj>> collect(unsigned threads, Keep keep) const
+    {
+        vector<vector<HashedObj>> parts(rangeThreads(array.size(), threads));
+        parallelForEach(threads, [&](unsigned t, SizeType currentPos, const HashedObj &x)
+                        {
+                            if (keep(currentPos, x))
+                                parts[t].push_back(x);
+                        });
+        return parts;
+    }
+
+    /**
+     * Build a table of the objs in parts and, if whole is given, of
+     * every obj in whole. The objs must all differ. The table is sized
+     * for them up front, so it never rehashes while they go in.
+     *
+     * @param parts The objs, e.g. from collect( ); they are moved from.
+     * @param whole A table to copy every obj of, or nullptr.
+     * @param threads The number of threads; 0 for one per core.
+     * @return The new table.
+     */
+    static HashTable fromParts(vector<vector<HashedObj>> &parts,
+                               const HashTable *whole, unsigned threads)
+    {
+        size_t total = whole != nullptr ? whole->activeSize : 0;
+        for (auto &part : parts)
+            total += part.size();
+
+        // At most half full, so insert( ) never rehashes it
+        HashTable result(2 * total + 1);
+        if constexpr (CONCURRENT_INSERT)
+        {
+            if (whole != nullptr)
+                whole->parallelForEach(threads, [&](unsigned, SizeType, const HashedObj &x)
+                                       { result.insertConcurrent(x); });
+            parallelRanges(parts.size(), (unsigned)parts.size(),
+                           [&](unsigned, size_t lo, size_t hi)
+                           {
+                               for (size_t p = lo; p < hi; p++)
+                                   for (auto &x : parts[p])
+                                       result.insertConcurrent(x);
+                           });
+            result.currentSize = result.activeSize = (SizeType)total;
+        }
+        else
+        {
+            if (whole != nullptr)
+                for (auto &entry : whole->array)
+                    if (entry.isActive())
+                        result.insert(entry.element);
+            for (auto &part : parts)
+                for (auto &x : part)
+                    result.insert(std::move(x));
+        }
+        return result;
+    }
+
+    /**
+     * Insert an obj that is not in the table while other threads do
+     * the same. The obj claims the first EMPTY slot on its probe path
+     * with an atomic compare-and-swap; a slot once claimed stays full,
+     * so every obj is found where findPos( ) looks for it. The table
+     * must stay at most half full, as it does not rehash, and the
+     * caller updates the counts.
+     *
+     * @param x The obj to insert.
+     */
+    void insertConcurrent(HashedObj x)
+    {
+        if constexpr (CONCURRENT_INSERT)
+        {
+            SizeType offset = 1;
+            SizeType currentPos = myhash(x);
+            for (;;)
+            {
+                HashedObj expected = Sentinels::emptyKey();
+                if (__atomic_compare_exchange_n(&array[currentPos].element, &expected, x, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    return;
+                currentPos += offset;
+                offset += 2;
+                if (currentPos >= array.size())
+                    currentPos -= (SizeType)array.size();
+            }
+        }
+    }
+
+    /**
+     * Rehash all active entries after the table fills up. The table
+     * doubles in size unless most of the occupied entries are DELETED;
+     * then it is rebuilt at the same size to clear them out.
      */
     void rehash()
     {
-        vector<HashEntry> oldArray = array;
+        if (activeSize > array.size() / 4)
+            rehash(capacityFor(2 * array.size()));
+        else
+            rehash((SizeType)array.size());
+    }
 
-        // Create new double-sized, empty table
-        array.resize(nextPrime(2 * oldArray.size()));
-        for (auto &entry : array)
-            entry.info = EMPTY;
+    /**
+     * Rehash all active entries into a new, empty array.
+     *
+     * @param newSize The size of the new array.
+     */
+    void rehash(SizeType newSize)
+    {
+        EntryArray oldArray(newSize);
+        array.swap(oldArray);
 
-        // Copy table over
+        // Copy table over. Moving an obj out writes to the old array,
+        // which would first copy a page still shared with another copy
+        // of the table, so a shared old array is only read
         currentSize = 0;
-        for (auto &entry : oldArray)
-            if (entry.info == ACTIVE)
-                insert(std::move(entry.element));
+        activeSize = 0;
+        if (sharedSlotBytes(oldArray) == 0)
+        {
+            for (auto &entry : oldArray)
+                if (entry.isActive())
+                    insert(std::move(entry.element));
+        }
+        else
+        {
+            for (auto &entry : as_const(oldArray))
+                if (entry.isActive())
+                    insert(entry.element);
+        }
     }
 
     /**
@@ -264,14 +742,55 @@ private:
      * @param x The obj to hash.
      * @return The hash value for the obj.
      */
-    size_t myhash(const HashedObj &x) const
+    SizeType myhash(const HashedObj &x) const
     {
         // Using static here so the hf is reused accoss all calls
         static hash<HashedObj> hf;
 
         // Note: hf(x) returns the hash value for x
-        return hf(x) % array.size();
+        size_t h = hf(x);
+
+        // A compact table divides in SizeType, which is cheaper;
+        // fold in the high bits of the hash first so they still count
+        if constexpr (sizeof(SizeType) < sizeof(size_t))
+            h ^= h >> (8 * sizeof(SizeType));
+        return (SizeType)h % (SizeType)array.size();
+    }
+
+    /**
+     * Get the largest size of the array: half the largest SizeType,
+     * so that probing cannot overflow (see findPos).
+     *
+     * @return The largest capacity.
+     */
+    static size_t maxCapacity()
+    {
+        return min<size_t>(numeric_limits<SizeType>::max() / 2,
+                           EntryArray().max_size());
+    }
+
+    /**
+     * Get the size of an array of at least n slots.
+     *
+     * @param n The minimum size of the array.
+     * @return The smallest prime >= n.
+     * @throws std::length_error If that is above maxCapacity( ).
+     */
+    static SizeType capacityFor(size_t n)
+    {
+        if (n > maxCapacity())
+            throw length_error("HashTable capacity overflow");
+
+        size_t size = nextPrime(n);
+        if (size > maxCapacity())
+            throw length_error("HashTable capacity overflow");
+        return (SizeType)size;
     }
 };
 
+// Compiled once, into libbimap (QuadraticProbingInstances.cpp)
+extern template class HashTable<int>;
+extern template class HashTable<int64_t>;
+extern template class HashTable<string>;
+
 #endif
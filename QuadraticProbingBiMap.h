@@ -13,14 +13,19 @@ to meet the needs of the BiMap class. The hash table supports key/value
 insertion, removal, and lookup of key-value pairs.
 */
 
-#ifndef QUADRATIC_PROBING_H
-#define QUADRATIC_PROBING_H
+#ifndef QUADRATIC_PROBING_BI_MAP_H
+#define QUADRATIC_PROBING_BI_MAP_H
 
 #include <vector>
 #include <algorithm>
 #include <functional>
 #include <string>
-#include "QuadraticProbing.cpp"
+#include <limits>
+#include <stdexcept>
+#include "HashTableTraits.h"
+#include "BatchProbe.h"
+#include "MemoryUsage.h"
+#include "dsexceptions.h"
 using namespace std;
 
 /**
@@ -30,21 +35,47 @@ using namespace std;
  * @param n The minimum size of the hash table.
  * @return A prime number >= n.
  */
-int nextPrime(int n);
+size_t nextPrime(size_t n);
 
 // QuadraticProbing Hash table class
 //
-// CONSTRUCTION: an approximate initial size or default of 101
+// CONSTRUCTION: an approximate initial size or default of 101; a size
+//               of 0 allocates nothing until the first insert
+//
+// Traits::SizeType is the type of sizes and positions: size_t by
+// default, or uint32_t with CompactHashTableTraits. Growing the array
+// past half the largest SizeType throws std::length_error.
+// Traits::Allocator allocates the array, e.g. MmapAllocator for huge
+// pages, and Traits::SlotArray holds it, e.g. in copy-on-write pages.
+//
+// Traits::Sentinels selects the slot layout. With sentinels (the default
+// for integral keys) a slot holds only the key and value, and the state
+// is encoded in the key; keys equal to a sentinel go to a side slot.
 //
 // ******************PUBLIC OPERATIONS*********************
 // bool insert( k , v )       --> Insert key and value
 // bool remove( k )           --> Remove entry with key
 // bool contains( k )         --> Return true if key is present
+// void containsBatch( ks, n, found ) --> Set found[i] to contains( ks[i] )
 // HashedVal getVal( k )      --> Return the value with key
+// HashedVal *find( k )       --> Return the value with key, or nullptr
+// void forEach( f )          --> Call f( k, v ) for every pair
+// void setClockTracking( b ) --> Track reference bits for evict( )
+// void touch( k )            --> Set the reference bit of key k
+// bool evict( k, v, used )   --> Remove a pair chosen by CLOCK
 // void makeEmpty( )          --> Remove all items
+// void reserve( n )          --> Make room for n items
+// size_t getCapacity( )      --> Return the size of the array
+// size_t getRehashes( )      --> Return the number of rehashes so far
+// void setShrinkThreshold( f ) --> Shrink when the live load falls below f
+// double getShrinkThreshold( ) --> Return the shrink threshold
+// void shrinkToFit( )        --> Shrink the table to fit its items
+// MemoryUsage memoryUsage( ) --> Return the memory used by the table
+// HashTable snapshot( )      --> Return a copy without CLOCK state
 // int hashCode( string str ) --> Global method to hash strings
 
-template <typename HashedKey, typename HashedVal>
+template <typename HashedKey, typename HashedVal,
+          typename Traits = HashTableTraits<HashedKey>>
 class HashTable
 {
 public:
@@ -55,9 +86,14 @@ public:
      * number greater than or equal to the specified size. If no size is provided,
      * the default size is 101. 
      *
+     * A size of 0 allocates no array until the first insert, and
+     * makeEmpty( ) gives the whole array back.
+     *
      * @param size The initial size of the hash table (default: 101).
+     * @throws std::length_error If size is above the largest capacity.
      */
-    explicit HashTable(int size = 101) : array(nextPrime(size))
+    explicit HashTable(size_t size = 101)
+        : array(size == 0 ? 0 : capacityFor(size)), minCapacity((SizeType)array.size())
     {
         makeEmpty();
     }
@@ -70,11 +106,40 @@ public:
      */
     bool contains(const HashedKey &x) const
     {
+        // Keys equal to a sentinel live in a side slot
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+            return sideSlots.isUsed(side);
+
+        if (array.empty())
+            return false;
+
         // Locate the position of x in array.
         // Return true if x is in the array and is active
         return isActive(findPos(x));
     }
 
+    /**
+     * Check a batch of keys. A table of int keys with sentinels, whose
+     * entries are 8 bytes, in a vector, checks 8 keys at a time with
+     * AVX2 (see BatchProbe.h); other tables call contains( ) for each key.
+     *
+     * @param xs The keys to check.
+     * @param n The number of keys.
+     * @param found Set found[i] to true iff xs[i] is present.
+     */
+    void containsBatch(const HashedKey *xs, size_t n, bool *found) const
+    {
+        auto probe = [this](const HashedKey &x) { return contains(x); };
+        if constexpr (BATCH_KERNEL) // The key is the first member of an entry
+            batchContains<sizeof(HashEntry)>((const int *)array.data(), array.size(),
+                                             Sentinels::emptyKey(), Sentinels::deletedKey(),
+                                             xs, n, found, probe);
+        else
+            for (size_t i = 0; i < n; i++)
+                found[i] = probe(xs[i]);
+    }
+
     /**
      * Get the value associated with the specified key.
      *
@@ -84,9 +149,245 @@ public:
      */
     HashedVal getVal(const HashedKey &x) const
     {
-        if (!contains(x))
+        const HashedVal *y = find(x);
+        if (y == nullptr)
             throw std::runtime_error("Key not found in hash table.");
-        return array[findPos(x)].value;
+        return *y;
+    }
+
+    /**
+     * Find the value associated with the specified key, with a single
+     * probe sequence.
+     *
+     * @param x The key to look up.
+     * @return The value, or nullptr if the key is not in the hash table.
+     *         It is valid until the table is next modified.
+     */
+    const HashedVal *find(const HashedKey &x) const
+    {
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+            return sideSlots.isUsed(side) ? &sideSlots.value(side) : nullptr;
+        if (array.empty())
+            return nullptr;
+
+        SizeType currentPos = findPos(x);
+        if (!isActive(currentPos))
+            return nullptr;
+
+        if (!refBits.empty())
+            refBits[currentPos] = 1;
+        return &array[currentPos].value;
+    }
+
+    /**
+     * Turn tracking of CLOCK reference bits on or off. While on,
+     * getVal( ) and touch( ) mark a pair as recently used, and
+     * evict( ) can be called.
+     *
+     * @param on True to track reference bits.
+     */
+    void setClockTracking(bool on)
+    {
+        refBits.assign(on ? array.size() : 0, 0);
+        clockHand = 0;
+    }
+
+    /**
+     * Mark the pair with the specified key as recently used.
+     * Does nothing unless clock tracking is on.
+     *
+     * @param x The key of the pair.
+     */
+    void touch(const HashedKey &x) const
+    {
+        if (refBits.empty() || array.empty() || Sentinels::reservedIndex(x) >= 0)
+            return;
+
+        SizeType currentPos = findPos(x);
+        if (isActive(currentPos))
+            refBits[currentPos] = 1;
+    }
+
+    /**
+     * Remove a pair that has not been used recently, chosen by the
+     * CLOCK policy: the hand sweeps the array, clearing reference
+     * bits, and stops at the first active pair whose bit is clear.
+     * Pairs in side slots are chosen only when the array holds no
+     * pair, so that a table of sentinel keys can still make room.
+     * Needs clock tracking.
+     * New pairs start with a clear bit, and a rehash clears all bits.
+     *
+     * @param x Set to the key of the removed pair.
+     * @param y Set to the value of the removed pair.
+     * @param wasUsed Called as wasUsed(k, v) on a pair whose bit is
+     *        clear; returning true gives the pair one more chance, as
+     *        if its bit had been set. For use of a pair that the table
+     *        did not see, e.g. through a cache in front of it. It must
+     *        return false when called again on the same pair before the
+     *        pair is used again.
+     * @return True if a pair was removed, false if there was none.
+     */
+    template <typename UsedPredicate>
+    bool evict(HashedKey &x, HashedVal &y, UsedPredicate wasUsed)
+    {
+        if (refBits.empty())
+            return false;
+        if (activeSize == 0)
+        {
+            if constexpr (Sentinels::enabled)
+                for (int side = 0; side < 2; side++)
+                    if (sideSlots.isUsed(side))
+                    {
+                        x = side == 0 ? Sentinels::emptyKey() : Sentinels::deletedKey();
+                        y = sideSlots.value(side);
+                        sideSlots.clear(side);
+                        return true;
+                    }
+            return false;
+        }
+
+        // One sweep clears every bit and a second every wasUsed
+        // chance, so a victim is always found by the third
+        for (size_t step = 0; step <= 3 * array.size(); step++)
+        {
+            SizeType currentPos = clockHand;
+            if (++clockHand == array.size())
+                clockHand = 0;
+
+            if (!isActive(currentPos))
+                continue;
+            if (refBits[currentPos])
+            {
+                refBits[currentPos] = 0;
+                continue;
+            }
+            if (wasUsed(array[currentPos].key, array[currentPos].value))
+                continue;
+
+            x = std::move(array[currentPos].key);
+            y = std::move(array[currentPos].value);
+            array[currentPos].markDeleted();
+            --activeSize;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Call f(key, value) for every key-value pair in the hash table,
+     * in no particular order.
+     *
+     * @param f The visitor to call.
+     */
+    template <typename Visitor>
+    void forEach(Visitor f) const
+    {
+        for (auto &entry : array)
+            if (entry.isActive())
+                f(entry.key, entry.value);
+        sideSlots.template forEach<Sentinels>(f);
+    }
+
+    /**
+     * Get the number of slots in the array.
+     *
+     * @return The size of the array.
+     */
+    size_t getCapacity() const { return array.size(); }
+
+    /**
+     * Get the number of rehashes so far, including those that clear
+     * DELETED entries at the same size.
+     *
+     * @return The number of rehashes.
+     */
+    size_t getRehashes() const { return rehashes; }
+
+    /**
+     * Report the memory used by the hash table. Walks every slot.
+     *
+     * @return The memory usage of the table.
+     */
+    MemoryUsage memoryUsage() const
+    {
+        static PayloadHeapBytes<HashedKey> keyBytes;
+        static PayloadHeapBytes<HashedVal> valBytes;
+
+        MemoryUsage usage;
+        usage.capacity = array.size();
+        usage.slotBytes = array.capacity() * sizeof(HashEntry);
+        usage.objectBytes = sizeof(*this);
+        usage.sharedBytes = sharedSlotBytes(array);
+        for (auto &entry : array)
+        {
+            if (entry.isActive())
+            {
+                ++usage.activeSlots;
+                usage.payloadHeapBytes += keyBytes(entry.key) + valBytes(entry.value);
+            }
+            else if (entry.isDeleted())
+                ++usage.deletedSlots;
+        }
+
+        auto addSide = [&](const HashedKey &k, const HashedVal &v)
+        { usage.payloadHeapBytes += keyBytes(k) + valBytes(v); };
+        sideSlots.template forEach<Sentinels>(addSide);
+
+        usage.overheadBytes = usage.capacity *
+                              (sizeof(HashEntry) - sizeof(HashedKey) - sizeof(HashedVal));
+
+        // The reference bits are slot overhead too
+        usage.slotBytes += refBits.capacity();
+        usage.overheadBytes += refBits.capacity();
+        usage.wastedBytes = (usage.capacity - usage.activeSlots) * sizeof(HashEntry);
+        return usage;
+    }
+
+    /**
+     * Copy the table for reading. The copy leaves out the CLOCK
+     * reference bits, so reading it writes nothing. With paged slots
+     * (CowHashTableTraits) it shares the slot pages and costs O(1);
+     * otherwise it copies the slot array.
+     *
+     * @return The copy.
+     */
+    HashTable snapshot() const
+    {
+        return HashTable(*this, false);
+    }
+
+    /**
+     * Set the live load below which remove( ) shrinks the table.
+     * A shrink leaves the table a quarter full, so it takes many
+     * more removals, or a doubling of the entries, before the next
+     * resize. The table never shrinks below its initial size.
+     *
+     * @param fraction The shrink threshold in [0, 0.25); 0 turns it off.
+     * @throws IllegalArgumentException If fraction is out of range.
+     */
+    void setShrinkThreshold(double fraction)
+    {
+        if (fraction < 0 || fraction >= 0.25)
+            throw IllegalArgumentException{};
+        shrinkLoad = fraction;
+    }
+
+    /**
+     * Get the live load below which remove( ) shrinks the table.
+     *
+     * @return The shrink threshold; 0 if shrinking is off.
+     */
+    double getShrinkThreshold() const { return shrinkLoad; }
+
+    /**
+     * Shrink the table to the smallest size that holds its
+     * entries, clearing out all DELETED entries.
+     */
+    void shrinkToFit()
+    {
+        rehash(capacityFor(max<size_t>(2 * (size_t)activeSize + 1, 3)));
     }
 
     /**
@@ -94,9 +395,35 @@ public:
      */
     void makeEmpty()
     {
-        for (auto &entry : array)
-            entry.info = EMPTY;
+        // Give back the memory of a table that has grown, or of one
+        // whose pages a snapshot shares, rather than copy them to clear
+        if (array.size() > minCapacity || sharedSlotBytes(array) != 0)
+            EntryArray(minCapacity).swap(array);
+        else
+            for (auto &entry : array)
+                entry.markEmpty();
+        sideSlots.clearAll();
         currentSize = 0;
+        activeSize = 0;
+        if (!refBits.empty())
+            refBits.assign(array.size(), 0);
+    }
+
+    /**
+     * Make room for n entries, so that inserting them does not
+     * rehash the table. If the table is big enough but for its
+     * DELETED entries, it is rebuilt at the same size; it never
+     * shrinks.
+     *
+     * @param n The number of entries.
+     * @throws std::length_error If the table would be too large.
+     */
+    void reserve(size_t n)
+    {
+        if (n > maxCapacity() / 2)
+            throw length_error("HashTable capacity overflow");
+        if (n > array.size() / 2 - (currentSize - activeSize))
+            rehash((SizeType)max<size_t>({capacityFor(2 * n + 1), array.size(), minCapacity}));
     }
 
     /**
@@ -108,8 +435,19 @@ public:
      */
     bool insert(const HashedKey &x, const HashedVal &y)
     {
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (sideSlots.isUsed(side))
+                return false;
+            sideSlots.set(side, y);
+            return true;
+        }
+        if (array.empty())
+            rehash(capacityFor(1));
+
         // Insert x as active
-        int currentPos = findPos(x);
+        SizeType currentPos = findInsertPos(x);
 
         // If the position is already occupied by active element,
         // this mean the hash table is full.
@@ -118,15 +456,18 @@ public:
 
         // If the position is not maked as DELETED or ACTIVE,
         // meaning the position is EMPTY and is available to insertion.
-        if (array[currentPos].info != DELETED)
+        if (!array[currentPos].isDeleted())
             ++currentSize;
 
         array[currentPos].key = x; // Store the key
         array[currentPos].value = y; // Store the value
-        array[currentPos].info = ACTIVE;
+        array[currentPos].markActive();
+        ++activeSize;
+        if (!refBits.empty())
+            refBits[currentPos] = 0;
 
         // Rehash; see Section 5.5
-        if (currentSize > (int)array.size() / 2)
+        if (currentSize > array.size() / 2)
             rehash();
 
         return true;
@@ -141,8 +482,19 @@ public:
      */
     bool insert(HashedKey &&x, HashedVal &&y)
     {
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (sideSlots.isUsed(side))
+                return false;
+            sideSlots.set(side, std::move(y));
+            return true;
+        }
+        if (array.empty())
+            rehash(capacityFor(1));
+
         // Insert x as active
-        int currentPos = findPos(x);
+        SizeType currentPos = findInsertPos(x);
 
         // If the position is already occupied by active element,
         // this mean the hash table is full.
@@ -151,16 +503,19 @@ public:
 
         // If the position is not maked as DELETED or ACTIVE,
         // meaning the position is EMPTY and is available to insertion.
-        if (array[currentPos].info != DELETED)
+        if (!array[currentPos].isDeleted())
             ++currentSize;
 
         // Use move semantics to avoid expensive copying
         array[currentPos].key = std::move(x);
         array[currentPos].value = std::move(y);
-        array[currentPos].info = ACTIVE;
+        array[currentPos].markActive();
+        ++activeSize;
+        if (!refBits.empty())
+            refBits[currentPos] = 0;
 
         // Rehash; see Section 5.5
-        if (currentSize > (int)array.size() / 2)
+        if (currentSize > array.size() / 2)
             rehash();
 
         return true;
@@ -174,14 +529,30 @@ public:
      */
     bool remove(const HashedKey &x)
     {
-        int currentPos = findPos(x);
+        int side = Sentinels::reservedIndex(x);
+        if (side >= 0)
+        {
+            if (!sideSlots.isUsed(side))
+                return false;
+            sideSlots.clear(side);
+            return true;
+        }
+        if (array.empty())
+            return false;
+
+        SizeType currentPos = findPos(x);
 
         // If the position is either EMPTY or DELETE,
         // this mean x is not in the array.
         if (!isActive(currentPos))
             return false;
 
-        array[currentPos].info = DELETED;
+        array[currentPos].markDeleted();
+        --activeSize;
+
+        // Shrink once the table is mostly empty
+        if (activeSize < shrinkLoad * array.size() && array.size() > minCapacity)
+            rehash(capacityFor(max<size_t>(4 * (size_t)activeSize, minCapacity)));
         return true;
     }
 
@@ -196,11 +567,15 @@ public:
     };
 
 private:
+    typedef typename Traits::Sentinels Sentinels;
+    typedef typename Traits::SizeType SizeType; // Type of sizes and positions
+
     /**
      * Represents an entry in the hash table, 
      * storing a key, value, and status.
      */
-    struct HashEntry
+    template <bool Packed, typename Unused = void>
+    struct Entry
     {
         HashedKey key;   // The key being stored
         HashedVal value; // The value being stored
@@ -213,7 +588,7 @@ private:
          * @param v The value to store (default: default-constructed HashedVal).
          * @param i The status of the entry (default: EMPTY).
          */
-        HashEntry(const HashedKey &k = HashedKey(),
+        Entry(const HashedKey &k = HashedKey(),
                   const HashedVal &v = HashedVal(),
                   EntryType i = EMPTY)
             : key{k},
@@ -227,16 +602,89 @@ private:
          * @param v The value to store (rvalue reference).
          * @param i The status of the entry (default: EMPTY).
          */
-        HashEntry(HashedKey &&k,
+        Entry(HashedKey &&k,
                   HashedVal &&v,
                   EntryType i = EMPTY)
             : key{std::move(k)},
               value{std::move(v)},
               info{i} {}
+
+        bool isActive() const { return info == ACTIVE; }
+        bool isEmpty() const { return info == EMPTY; }
+        bool isDeleted() const { return info == DELETED; }
+
+        void markActive() { info = ACTIVE; }
+        void markEmpty() { info = EMPTY; }
+        void markDeleted() { info = DELETED; }
+    };
+
+    /**
+     * Represents an entry in a hash table with sentinels,
+     * storing only a key and value. The status is encoded
+     * in the key: EMPTY and DELETED are sentinel keys.
+     */
+    template <typename Unused>
+    struct Entry<true, Unused>
+    {
+        HashedKey key;   // The key being stored, or a sentinel
+        HashedVal value; // The value being stored
+
+        /**
+         * Constructor for an EMPTY entry.
+         */
+        Entry() : key{Sentinels::emptyKey()}, value{} {}
+
+        bool isActive() const
+        {
+            return key != Sentinels::emptyKey() && key != Sentinels::deletedKey();
+        }
+        bool isEmpty() const { return key == Sentinels::emptyKey(); }
+        bool isDeleted() const { return key == Sentinels::deletedKey(); }
+
+        void markActive() {}
+        void markEmpty() { key = Sentinels::emptyKey(); }
+        void markDeleted() { key = Sentinels::deletedKey(); }
     };
 
-    vector<HashEntry> array; // Array that holds the HashEntries
-    int currentSize;         // The current size of the array
+    typedef Entry<Sentinels::enabled> HashEntry;
+    typedef typename Traits::template SlotArray<
+        HashEntry, typename Traits::template Allocator<HashEntry>> EntryArray;
+
+    // True if containsBatch( ) can use the batch kernel: int keys
+    // with sentinels, in 8-byte entries, in one contiguous array
+    static constexpr bool BATCH_KERNEL =
+        is_same<HashedKey, int>::value && Sentinels::enabled && sizeof(HashEntry) == 8 &&
+        is_same<EntryArray, vector<HashEntry, typename Traits::template Allocator<HashEntry>>>::value;
+
+    EntryArray array;        // Array that holds the HashEntries
+    SizeType currentSize;    // The number of ACTIVE and DELETED entries
+    SizeType activeSize;     // The number of ACTIVE entries
+    SizeType minCapacity;    // The initial size, the smallest after a shrink
+    double shrinkLoad = 0.125; // Shrink when activeSize falls below this load
+    size_t rehashes = 0;     // The number of rehashes so far
+
+    // CLOCK reference bit per slot; empty unless clock tracking is on
+    mutable vector<unsigned char> refBits;
+    SizeType clockHand = 0; // The next slot the CLOCK hand looks at
+
+    // Entries whose key is a sentinel
+    SideSlots<HashedVal, Sentinels::enabled> sideSlots;
+
+    /**
+     * Copy constructor for snapshot( ), which can leave out the
+     * CLOCK state.
+     *
+     * @param rhs The table to copy.
+     * @param withClock True to copy the reference bits.
+     */
+    HashTable(const HashTable &rhs, bool withClock)
+        : array(rhs.array), currentSize(rhs.currentSize),
+          activeSize(rhs.activeSize), minCapacity(rhs.minCapacity),
+          shrinkLoad(rhs.shrinkLoad),
+          refBits(withClock ? rhs.refBits : vector<unsigned char>()),
+          clockHand(withClock ? rhs.clockHand : 0), sideSlots(rhs.sideSlots)
+    {
+    }
 
     /**
      * Check if the entry at the specified position is active.
@@ -244,9 +692,9 @@ private:
      * @param currentPos The position to check.
      * @return True if the entry is active, false otherwise.
      */
-    bool isActive(int currentPos) const
+    bool isActive(SizeType currentPos) const
     {
-        return array[currentPos].info == ACTIVE;
+        return array[currentPos].isActive();
     }
 
     /**
@@ -255,43 +703,114 @@ private:
      * @param x The key to find.
      * @return The position of the key or the first empty position.
      */
-    int findPos(const HashedKey &x) const
+    SizeType findPos(const HashedKey &x) const
     {
-        int offset = 1;             // Offset value for hash(x)
-        int currentPos = myhash(x); // Returns the initial hash index
+        // The table is at most half full, so a free slot turns up
+        // within array.size() / 2 probes: offset stays below
+        // array.size(), and one subtraction wraps currentPos. As
+        // array.size() is at most half the largest SizeType,
+        // currentPos + offset cannot overflow.
+        SizeType offset = 1;        // Offset value for hash(x)
+        SizeType currentPos = myhash(x); // Returns the initial hash index
 
         // Stop searching if current position is
         // EMPTY or the element is found.
-        while (array[currentPos].info != EMPTY &&
+        while (!array[currentPos].isEmpty() &&
                array[currentPos].key != x)
         {
             currentPos += offset; // Compute ith probe
             offset += 2;
             // same effect as mod array.size()
-            if (currentPos >= (int)array.size())
-                currentPos -= (int)array.size();
+            if (currentPos >= array.size())
+                currentPos -= (SizeType)array.size();
         }
 
         return currentPos;
     }
 
     /**
-     * Resize the hash table to a larger size and rehash all active entries.
+     * Find where to insert the specified key: the position of the key
+     * if it is active, or else the first DELETED position on its probe
+     * path, or else the empty position that ends the path. Reusing a
+     * DELETED position keeps a key that is removed and inserted again
+     * from leaving a DELETED entry behind each time.
+     *
+     * @param x The key to find.
+     * @return The position of the key or the position to insert it.
      */
-    void rehash()
+    SizeType findInsertPos(const HashedKey &x) const
     {
-        vector<HashEntry> oldArray = array;
+        SizeType offset = 1;
+        SizeType currentPos = myhash(x);
+        SizeType deletedPos = 0;
+        bool sawDeleted = false;
+
+        // Probe to the end of the path, as the key may still be
+        // active past a DELETED position
+        while (!array[currentPos].isEmpty())
+        {
+            if (array[currentPos].isDeleted())
+            {
+                if (!sawDeleted)
+                    deletedPos = currentPos;
+                sawDeleted = true;
+            }
+            else if (array[currentPos].key == x)
+                return currentPos;
+
+            currentPos += offset;
+            offset += 2;
+            if (currentPos >= array.size())
+                currentPos -= (SizeType)array.size();
+        }
 
-        // Create new double-sized, empty table
-        array.resize(nextPrime(2 * oldArray.size()));
-        for (auto &entry : array)
-            entry.info = EMPTY;
+        return sawDeleted ? deletedPos : currentPos;
+    }
 
-        // Copy table over
+    /**
+     * Rehash all active entries after the table fills up. The table
+     * doubles in size unless most of the occupied entries are DELETED;
+     * then it is rebuilt at the same size to clear them out.
+     */
+    void rehash()
+    {
+        if (activeSize > array.size() / 4)
+            rehash(capacityFor(2 * array.size()));
+        else
+            rehash((SizeType)array.size());
+    }
+
+    /**
+     * Rehash all active entries into a new, empty array.
+     *
+     * @param newSize The size of the new array.
+     */
+    void rehash(SizeType newSize)
+    {
+        EntryArray oldArray(newSize);
+        array.swap(oldArray);
+        ++rehashes;
+        if (!refBits.empty())
+            refBits.assign(array.size(), 0);
+        clockHand = 0;
+
+        // Copy table over. Moving an entry out writes to the old array,
+        // which would first copy a page still shared with a snapshot,
+        // so a shared old array is only read
         currentSize = 0;
-        for (auto &entry : oldArray)
-            if (entry.info == ACTIVE)
-                insert(std::move(entry.key), std::move(entry.value));
+        activeSize = 0;
+        if (sharedSlotBytes(oldArray) == 0)
+        {
+            for (auto &entry : oldArray)
+                if (entry.isActive())
+                    insert(std::move(entry.key), std::move(entry.value));
+        }
+        else
+        {
+            for (auto &entry : as_const(oldArray))
+                if (entry.isActive())
+                    insert(entry.key, entry.value);
+        }
     }
 
     /**
@@ -300,14 +819,61 @@ private:
      * @param x The key to hash.
      * @return The hash value for the key.
      */
-    size_t myhash(const HashedKey &x) const
+    SizeType myhash(const HashedKey &x) const
     {
         // Using static here so the hf is reused accoss all calls
         static hash<HashedKey> hf;
 
         // Note: hf(x) returns the hash value for x
-        return hf(x) % array.size();
+        size_t h = hf(x);
+
+        // A compact table divides in SizeType, which is cheaper;
+        // fold in the high bits of the hash first so they still count
+        if constexpr (sizeof(SizeType) < sizeof(size_t))
+            h ^= h >> (8 * sizeof(SizeType));
+        return (SizeType)h % (SizeType)array.size();
+    }
+
+    /**
+     * Get the largest size of the array: half the largest SizeType,
+     * so that probing cannot overflow (see findPos).
+     *
+     * @return The largest capacity.
+     */
+    static size_t maxCapacity()
+    {
+        return min<size_t>(numeric_limits<SizeType>::max() / 2,
+                           EntryArray().max_size());
+    }
+
+    /**
+     * Get the size of an array of at least n slots.
+     *
+     * @param n The minimum size of the array.
+     * @return The smallest prime >= n.
+     * @throws std::length_error If that is above maxCapacity( ).
+     */
+    static SizeType capacityFor(size_t n)
+    {
+        if (n > maxCapacity())
+            throw length_error("HashTable capacity overflow");
+
+        size_t size = nextPrime(n);
+        if (size > maxCapacity())
+            throw length_error("HashTable capacity overflow");
+        return (SizeType)size;
     }
 };
 
+// Compiled once, into libbimap (BiMapInstances.cpp)
+extern template class HashTable<int, int>;
+extern template class HashTable<int, int64_t>;
+extern template class HashTable<int, string>;
+extern template class HashTable<int64_t, int>;
+extern template class HashTable<int64_t, int64_t>;
+extern template class HashTable<int64_t, string>;
+extern template class HashTable<string, int>;
+extern template class HashTable<string, int64_t>;
+extern template class HashTable<string, string>;
+
 #endif
@@ -0,0 +1,21 @@
+/*
+Full name:    Eric Cheung
+Student ID:   301125805
+Computing-id: hccheung
+
+Copyright Notice:
+This code is part of the assignment 2a for CSPT 225, Spring 2025.
+Unauthorized copying or distribution is prohibited.
+
+Purpose of this file:
+This file compiles the HashTable sets of int, int64_t and string
+into libbimap, once, for the extern templates in QuadraticProbing.h.
+*/
+#include <cstdint>
+#include <string>
+#include "QuadraticProbing.h"
+using namespace std;
+
+template class HashTable<int>;
+template class HashTable<int64_t>;
+template class HashTable<string>;
@@ -13,12 +13,48 @@ It verify the correctness of the BiMap public operations.
 Please refer to BiMap.h for documantation.
 */
 #include <iostream>
+#include <climits>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include "BiMap.h"
+#include "FrozenBiMap.h"
+#include "ConstexprBiMap.h"
 using namespace std;
 
+// A compile-time map used by the ConstexprBiMap tests
+enum class Color { Red, Green, Blue };
+constexpr auto colorNames = makeConstexprBiMap<Color, string_view>({
+    {Color::Red, "red"}, {Color::Green, "green"}, {Color::Blue, "blue"}});
+
+static_assert(colorNames.getSize() == 3, "ConstexprBiMap: wrong size");
+static_assert(colorNames.getVal(Color::Green) == "green",
+              "ConstexprBiMap: getVal is not folded");
+static_assert(colorNames.getKey("blue") == Color::Blue,
+              "ConstexprBiMap: getKey is not folded");
+static_assert(!colorNames.containsVal("purple"),
+              "ConstexprBiMap: containsVal found a missing value");
+
+// Bytes allocated by operator new, to check what a write copies
+atomic<size_t> allocatedBytes(0);
+
+void *operator new(size_t n)
+{
+    allocatedBytes += n;
+    if (void *p = malloc(n ? n : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
 // Check if an exception is thrown for getKey
-template <typename KeyType, typename ValType>
-bool testGetKeyException(BiMap<KeyType, ValType>& bimap, const ValType& val) {
+template <typename Map, typename ValType>
+bool testGetKeyException(Map& bimap, const ValType& val) {
     try {
         bimap.getKey(val);
         return false; // No exception thrown
@@ -28,8 +64,8 @@ bool testGetKeyException(BiMap<KeyType, ValType>& bimap, const ValType& val) {
 }
 
 // Check if an exception is thrown for getVal
-template <typename KeyType, typename ValType>
-bool testGetValException(BiMap<KeyType, ValType>& bimap, const KeyType& key) {
+template <typename Map, typename KeyType>
+bool testGetValException(Map& bimap, const KeyType& key) {
     try {
         bimap.getVal(key);
         return false; // No exception thrown
@@ -128,5 +164,530 @@ int main() {
     if (bm6.getSize() != 0)
         cout << "FAIL makeEmpty: should remove all pairs from the map." << endl;
 
+    // Test: keys and values equal to the int sentinels use the side slots
+    BiMap<int, int> bm7;
+    bm7.insert(INT_MAX, INT_MAX - 1);
+    bm7.insert(INT_MAX - 1, INT_MAX);
+    for (int i = 0; i < 500; i++)
+        bm7.insert(i, -i - 1);
+    if (bm7.getVal(INT_MAX) != INT_MAX - 1 || bm7.getKey(INT_MAX) != INT_MAX - 1)
+        cout << "FAIL sentinels: did not find a pair stored in a side slot." << endl;
+    if (bm7.insert(INT_MAX, 7) || bm7.insert(7, INT_MAX - 1))
+        cout << "FAIL sentinels: Cannot insert duplicate sentinel key or value." << endl;
+    if (!bm7.removeVal(INT_MAX - 1) || bm7.containsKey(INT_MAX))
+        cout << "FAIL sentinels: did not remove a pair stored in a side slot." << endl;
+    if (bm7.getVal(499) != -500 || bm7.getSize() != 501)
+        cout << "FAIL sentinels: lost a pair after rehash." << endl;
+
+    // Test: custom sentinels and a map without sentinels
+    struct NegativeIdTraits : BiMapTraits<int, int>
+    {
+        struct KeyTableTraits : HashTableTraits<int>
+        {
+            typedef FixedSentinels<int, -1, -2> Sentinels;
+        };
+    };
+    BiMap<int, int, NegativeIdTraits> bm8;
+    bm8.insert(-1, 1);
+    bm8.insert(1, -1);
+    bm8.removeKey(1);
+    if (!bm8.containsKey(-1) || bm8.containsKey(1) || bm8.getVal(-1) != 1)
+        cout << "FAIL sentinels: custom sentinels mishandled a key." << endl;
+
+    BiMap<string, int> bm9;
+    bm9.insert("one", 1);
+    bm9.insert("two", 2);
+    bm9.removeKey("one");
+    if (bm9.containsVal(1) || bm9.getKey(2) != "two")
+        cout << "FAIL string keys: map without sentinels mishandled a pair." << endl;
+
+    // Test: FrozenBiMap finds every pair of the map it was built from
+    BiMap<int, int> bm10;
+    for (int i = 0; i < 5000; i++)
+        bm10.insert(i * 7, i);
+    bm10.insert(INT_MAX, -1);
+    FrozenBiMap<int, int> fm1(bm10);
+    if (fm1.getSize() != bm10.getSize())
+        cout << "FAIL FrozenBiMap: size differs from the map." << endl;
+    for (int i = 0; i < 5000; i++)
+        if (fm1.getVal(i * 7) != i || fm1.getKey(i) != i * 7)
+            cout << "FAIL FrozenBiMap: did not find pair " << i << endl;
+    if (fm1.getVal(INT_MAX) != -1 || fm1.containsKey(1) || fm1.containsVal(5000))
+        cout << "FAIL FrozenBiMap: mishandled a sentinel or missing key." << endl;
+
+    FrozenBiMap<string, int> fm2(bm9);
+    if (fm2.getKey(2) != "two" || fm2.containsKey("one"))
+        cout << "FAIL FrozenBiMap: mishandled a string key." << endl;
+
+    FrozenBiMap<int, int> fm3((BiMap<int, int>()));
+    if (fm3.containsKey(0) || !testGetValException(fm3, 0))
+        cout << "FAIL FrozenBiMap: empty map should not contain any key." << endl;
+
+    // Test: ConstexprBiMap lookups at run time
+    string name = "red";
+    if (colorNames.getKey(name) != Color::Red || colorNames.containsKey(Color(7)))
+        cout << "FAIL ConstexprBiMap: run-time lookup failed." << endl;
+    if (!testGetKeyException(colorNames, string_view("cyan")))
+        cout << "FAIL ConstexprBiMap: should throw exception if value is not in the map." << endl;
+
+    // Test: memoryUsage() counts entries, tombstones and string payloads
+    MemoryUsage mu1 = bm10.memoryUsage();
+    if (mu1.activeSlots != 2 * 5000 + 1 || mu1.overheadBytes != 0 ||
+        mu1.loadFactor() <= 0.0 || mu1.loadFactor() > 0.5)
+        cout << "FAIL memoryUsage: wrong slot counts for an int map." << endl;
+    BiMap<string, int> bm11;
+    bm11.insert(string(100, 'x'), 1);
+    bm11.insert("y", 2);
+    bm11.removeVal(2);
+    MemoryUsage mu2 = bm11.memoryUsage();
+    if (mu2.payloadHeapBytes < 100 || mu2.deletedSlots != 2 || mu2.overheadBytes == 0)
+        cout << "FAIL memoryUsage: wrong payload or tombstone count." << endl;
+    if (fm1.memoryUsage().wastedBytes != 0)
+        cout << "FAIL memoryUsage: FrozenBiMap should not waste slots." << endl;
+
+    // Test: a bounded map evicts instead of growing, keeping hot pairs
+    BiMap<int, int> bm12(101, 100);
+    size_t capacity = bm12.memoryUsage().capacity;
+    bm12.insert(0, 1000000);
+    bm12.insert(1, 1000001);
+    for (int i = 2; i < 10000; i++)
+    {
+        bm12.insert(i, i + 1000000);
+        bm12.getVal(0);
+        bm12.getKey(1000001);
+    }
+    if (bm12.getSize() != 100 || bm12.getEvictions() != 10000 - 100)
+        cout << "FAIL bounded: map should stay at its pair limit." << endl;
+    if (bm12.memoryUsage().capacity != capacity)
+        cout << "FAIL bounded: tables should not grow." << endl;
+    BiMap<int, int> bm38(101, 100);
+    bm38.insert(1, 1);
+    bm38.shrinkToFit();
+    if (bm38.memoryUsage().capacity != capacity)
+        cout << "FAIL bounded: shrinkToFit should keep the tables." << endl;
+    if (!bm12.containsKey(0) || !bm12.containsVal(1000001))
+        cout << "FAIL bounded: recently used pairs should not be evicted." << endl;
+    int pairs = 0;
+    bm12.forEachPair([&](int k, int v)
+                     { pairs += bm12.getKey(v) == k && bm12.getVal(k) == v; });
+    if (pairs != 100)
+        cout << "FAIL bounded: evicted pair left behind in one table." << endl;
+    testGetValException(bm12, -1);
+    if (bm12.getHits() != 2 * 9998 + 2 * 100 || bm12.getMisses() != 1)
+        cout << "FAIL bounded: wrong hit or miss count." << endl;
+
+    // A full bounded map whose keys are all sentinels evicts from the
+    // side slots
+    BiMap<int, int> bm35(101, 2);
+    bm35.insert(INT_MAX, 1);
+    bm35.insert(INT_MAX - 1, 2);
+    if (!bm35.insert(3, 3) || bm35.getSize() != 2 || bm35.getEvictions() != 1 ||
+        bm35.getVal(3) != 3 || bm35.containsKey(INT_MAX) || bm35.containsVal(1))
+        cout << "FAIL bounded: a pair in a side slot was not evicted." << endl;
+
+    // Test: removals shrink the tables; makeEmpty() restores the initial size
+    BiMap<int, int> bm13;
+    for (int i = 0; i < 20000; i++)
+        bm13.insert(i, -i);
+    for (int i = 0; i < 19990; i++)
+        bm13.removeKey(i);
+    if (bm13.memoryUsage().capacity > 2 * 1000 || bm13.getKey(-19995) != 19995)
+        cout << "FAIL shrink: tables did not shrink after removals." << endl;
+    bm13.shrinkToFit();
+    if (bm13.memoryUsage().capacity != 2 * 23 || bm13.getVal(19999) != -19999)
+        cout << "FAIL shrinkToFit: tables do not fit the pairs." << endl;
+    for (int i = 0; i < 1000; i++)
+        bm13.insert(i, -i);
+    bm13.makeEmpty();
+    if (bm13.memoryUsage().capacity != 2 * 101)
+        cout << "FAIL makeEmpty: tables should return to their initial size." << endl;
+
+    // Test: instrumentation records every operation and rehash
+    struct TimedTraits : BiMapTraits<int, int>
+    {
+        typedef LatencyInstrumentation Instrumentation;
+    };
+    BiMap<int, int, TimedTraits> bm14;
+    int rehashes = 0;
+    bm14.getInstrumentation().setRehashHook([&](const RehashEvent &e)
+                                            { rehashes += e.newCapacity > e.oldCapacity; });
+    for (int i = 0; i < 1000; i++)
+        bm14.insert(i, i);
+    for (int i = 0; i < 1000; i++)
+        bm14.getVal(i);
+    bm14.removeVal(5);
+    const LatencyInstrumentation &timing = bm14.getInstrumentation();
+    if (timing.getHistogram(OP_INSERT).getCount() != 1000 ||
+        timing.getHistogram(OP_GET_VAL).getCount() != 1000 ||
+        timing.getHistogram(OP_REMOVE_VAL).getCount() != 1)
+        cout << "FAIL instrumentation: wrong operation count." << endl;
+    // Each table doubles 5 times on the way from 101 to 3467 slots
+    if (rehashes != 2 * 5 || timing.getHistogram(OP_REHASH).getCount() != 2 * 5)
+        cout << "FAIL instrumentation: rehash hook not called for every rehash." << endl;
+
+    // Test: a rehash that only clears DELETED entries is reported too
+    BiMap<int, int, TimedTraits> bm33(1000);
+    int sameSize = 0;
+    bm33.getInstrumentation().setRehashHook([&](const RehashEvent &e)
+                                            { sameSize += e.newCapacity == e.oldCapacity; });
+    for (int i = 0; i < 2000; i++)
+    {
+        bm33.insert(i, i);
+        bm33.removeKey(i);
+    }
+    if (sameSize == 0 || bm33.getInstrumentation().getHistogram(OP_REHASH).getCount() == 0)
+        cout << "FAIL instrumentation: same-size rehash not reported." << endl;
+
+    // Test: a pair removed and inserted again reuses its DELETED entries
+    BiMap<int, int, TimedTraits> bm34(1000);
+    for (int i = 0; i < 200; i++)
+        bm34.insert(i, -i);
+    int reused = 0;
+    bm34.getInstrumentation().setRehashHook([&](const RehashEvent &)
+                                            { reused++; });
+    for (int i = 0; i < 20000; i++)
+    {
+        bm34.removeKey(i % 200);
+        bm34.insert(i % 200, -(i % 200));
+    }
+    if (reused != 0 || bm34.getSize() != 200 || bm34.getKey(-199) != 199)
+        cout << "FAIL insert: reinserted pairs left DELETED entries behind." << endl;
+    const LatencyHistogram &inserts = timing.getHistogram(OP_INSERT);
+    if (inserts.percentile(50) > inserts.percentile(99.9) ||
+        inserts.percentile(100) != inserts.getMax())
+        cout << "FAIL instrumentation: percentiles out of order." << endl;
+    if (sizeof(BiMap<int, int>) >= sizeof(bm14))
+        cout << "FAIL instrumentation: NoInstrumentation should take no space." << endl;
+
+    // Test: front caches serve repeated lookups and drop removed pairs
+    BiMap<int, string> bm15;
+    size_t uncachedBytes = bm15.memoryUsage().totalBytes();
+    bm15.setFrontCacheSize(64);
+    if (bm15.memoryUsage().totalBytes() < uncachedBytes + 2 * 64 * sizeof(int) ||
+        bm15.memoryUsage().overheadBytes < 2 * 64 * sizeof(int))
+        cout << "FAIL front cache: memoryUsage() left out the caches." << endl;
+    for (int i = 0; i < 1000; i++)
+        bm15.insert(i, to_string(i));
+    for (int round = 0; round < 3; round++)
+        for (int i = 0; i < 1000; i++)
+            if (bm15.getVal(i) != to_string(i) || bm15.getKey(to_string(i)) != i)
+                cout << "FAIL front cache: wrong pair for " << i << endl;
+    bm15.removeKey(7);
+    bm15.removeVal("8");
+    bm15.insert(8, "7");
+    bm15.insert(7, "8");
+    if (bm15.getVal(7) != "8" || bm15.getKey("7") != 8 || !testGetValException(bm15, 1000))
+        cout << "FAIL front cache: served a removed pair." << endl;
+    bm15.makeEmpty();
+    if (!testGetValException(bm15, 8) || !testGetKeyException(bm15, string("8")))
+        cout << "FAIL front cache: served a pair after makeEmpty." << endl;
+
+    BiMap<int, int> bm16(101, 50);
+    bm16.setFrontCacheSize(16);
+    for (int i = 0; i < 5000; i++)
+    {
+        bm16.insert(i, -i);
+        if (bm16.containsKey(0) && bm16.getVal(0) != 0)
+            cout << "FAIL front cache: wrong value in a bounded map." << endl;
+    }
+    if (!bm16.containsKey(0) || bm16.getSize() != 50 || bm16.containsVal(-100))
+        cout << "FAIL front cache: bounded map evicted a cached hot pair." << endl;
+
+    // A full bounded map whose every pair is both referenced and
+    // cached must still evict one to make room
+    BiMap<int, int> bm30(101, 4);
+    bm30.setFrontCacheSize(64);
+    for (int i = 1; i <= 4; i++)
+        bm30.insert(i, 100 + i);
+    for (int i = 1; i <= 4; i++)
+        bm30.getVal(i);
+    if (!bm30.insert(10, 110) || bm30.getEvictions() != 1 || bm30.getSize() != 4 ||
+        bm30.getVal(10) != 110)
+        cout << "FAIL front cache: a full bounded map rejected an insert." << endl;
+
+    // Test: a compact map works like the default one
+    BiMap<int, string, CompactBiMapTraits<int, string>> bm17;
+    for (int i = 0; i < 1000; i++)
+        bm17.insert(i, to_string(i));
+    for (int i = 0; i < 1000; i += 2)
+        bm17.removeKey(i);
+    if (bm17.getSize() != 500 || bm17.getVal(999) != "999" || bm17.getKey("1") != 1 ||
+        bm17.containsVal("998"))
+        cout << "FAIL compact: wrong pairs." << endl;
+
+    // Test: sizes that overflow the tables throw length_error
+    try
+    {
+        BiMap<int, int, CompactBiMapTraits<int, int>> bm18(101, (size_t)1 << 30);
+        cout << "FAIL compact: pair limit overflow not caught." << endl;
+    }
+    catch (const length_error &)
+    {
+    }
+    try
+    {
+        BiMap<int, int> bm19(SIZE_MAX - 1);
+        cout << "FAIL 64-bit: capacity overflow not caught." << endl;
+    }
+    catch (const length_error &)
+    {
+    }
+
+    // Test: a snapshot keeps the pairs as they were, and shares the
+    // pages the map has not written to since
+    BiMap<int, int, CowBiMapTraits<int, int>> bm20;
+    for (int i = 0; i < 100000; i++)
+        bm20.insert(i, -i);
+    auto snap1 = bm20.snapshot();
+    MemoryUsage cow = bm20.memoryUsage();
+    if (cow.sharedBytes != cow.slotBytes)
+        cout << "FAIL snapshot: a new snapshot should share every page." << endl;
+    bm20.removeKey(5);
+    bm20.insert(5, 5);
+    cow = bm20.memoryUsage();
+    if (cow.slotBytes - cow.sharedBytes > 4 * PagedArray<pair<int, int>>::PAGE_BYTES)
+        cout << "FAIL snapshot: a write copied more than its pages." << endl;
+    for (int i = 100000; i < 300000; i++) // Grows and rehashes both tables
+        bm20.insert(i, -i);
+    for (int i = 0; i < 50000; i++)
+        bm20.removeVal(-i);
+    if (snap1.getSize() != 100000 || snap1.getVal(5) != -5 || snap1.getKey(-49999) != 49999 ||
+        snap1.containsKey(100000) || !testGetValException(snap1, 200000))
+        cout << "FAIL snapshot: changed by later writes to the map." << endl;
+    if (bm20.getSize() != 250001 || bm20.getVal(5) != 5 || bm20.getVal(299999) != -299999)
+        cout << "FAIL snapshot: the map lost writes." << endl;
+    long long sum = 0;
+    snap1.forEachPair([&](int k, int v) { sum += k + v; });
+    if (sum != 0)
+        cout << "FAIL snapshot: forEachPair saw a changed pair." << endl;
+
+    // Test: readers of a snapshot see it unchanged while the map is written
+    auto snap2 = bm20.snapshot();
+    bool readerFailed = false;
+    thread reader([&]
+                  {
+                      for (int round = 0; round < 5; round++)
+                          for (int i = 50000; i < 300000; i += 7)
+                              if (snap2.getVal(i) != -i || snap2.getKey(-i) != i)
+                                  readerFailed = true; });
+    for (int i = 50000; i < 300000; i++)
+    {
+        bm20.removeKey(i);
+        bm20.insert(i, i + 1000000);
+    }
+    reader.join();
+    if (readerFailed || bm20.getVal(50000) != 1050000)
+        cout << "FAIL snapshot: a reader saw a write to the map." << endl;
+
+    // Test: a rehash after a snapshot reads the old pages and leaves
+    // them to the snapshot, rather than copying them first
+    BiMap<int, int, CowBiMapTraits<int, int>> bm31, bm32;
+    for (int i = 0; i < 100000; i++)
+    {
+        bm31.insert(i, -i);
+        bm32.insert(i, -i);
+    }
+    for (int i = 0; i < 60000; i++)
+    {
+        bm31.removeKey(i);
+        bm32.removeKey(i);
+    }
+    auto snap6 = bm31.snapshot();
+    size_t before = allocatedBytes;
+    bm31.shrinkToFit();
+    size_t withSnapshot = allocatedBytes - before;
+    before = allocatedBytes;
+    bm32.shrinkToFit();
+    size_t withoutSnapshot = allocatedBytes - before;
+    if (withSnapshot > withoutSnapshot + PagedArray<pair<int, int>>::PAGE_BYTES ||
+        bm31.memoryUsage().sharedBytes != 0 || snap6.getSize() != 40000 ||
+        snap6.getVal(99999) != -99999 || bm31.getKey(-60000) != 60000)
+        cout << "FAIL snapshot: a rehash copied the pages it shares." << endl;
+    before = allocatedBytes;
+    bm31.makeEmpty();
+    if (allocatedBytes - before > bm31.memoryUsage().slotBytes + 4096 || snap6.getVal(70000) != -70000)
+        cout << "FAIL snapshot: makeEmpty copied the pages it shares." << endl;
+
+    // Test: without paged slots a snapshot is a copy
+    BiMap<int, string> bm21;
+    bm21.insert(1, "one");
+    auto snap3 = bm21.snapshot();
+    bm21.removeKey(1);
+    if (snap3.getVal(1) != "one" || snap3.memoryUsage().sharedBytes != 0)
+        cout << "FAIL snapshot: copy of a vector-backed map." << endl;
+
+    // Test: a small map keeps up to 8 pairs inline without allocating,
+    // then moves to its tables, and back with shrinkToFit
+    BiMap<int, int, SmallBiMapTraits<int, int>> bm22;
+    if (!bm22.isSmall() || bm22.memoryUsage().slotBytes != 0)
+        cout << "FAIL small: a new map should not allocate its tables." << endl;
+    for (int i = 0; i < 8; i++)
+        bm22.insert(i, 100 + i);
+    if (bm22.insert(3, 200) || bm22.insert(200, 103) || !bm22.isSmall() ||
+        bm22.getSize() != 8 || bm22.getVal(7) != 107 || bm22.getKey(100) != 0 ||
+        !testGetValException(bm22, 8) || bm22.memoryUsage().slotBytes != 0)
+        cout << "FAIL small: wrong inline pairs." << endl;
+    bm22.removeKey(0);
+    bm22.removeVal(107);
+    if (bm22.containsKey(0) || bm22.containsVal(107) || bm22.getVal(6) != 106)
+        cout << "FAIL small: remove of an inline pair." << endl;
+    for (int i = 10; i < 20; i++)
+        bm22.insert(i, 100 + i);
+    if (bm22.isSmall() || bm22.getSize() != 16 || bm22.getVal(1) != 101 ||
+        bm22.getKey(119) != 19 || bm22.containsKey(0))
+        cout << "FAIL small: pairs lost moving to the tables." << endl;
+    auto snap4 = bm22.snapshot();
+    for (int i = 10; i < 20; i++)
+        bm22.removeKey(i);
+    bm22.shrinkToFit();
+    if (!bm22.isSmall() || bm22.memoryUsage().slotBytes != 0 || bm22.getSize() != 6 ||
+        bm22.getKey(103) != 3 || snap4.getSize() != 16 || snap4.getVal(15) != 115)
+        cout << "FAIL small: shrinkToFit should move the pairs back inline." << endl;
+    auto snap5 = bm22.snapshot();
+    bm22.makeEmpty();
+    if (!bm22.isSmall() || bm22.containsKey(1) || snap5.getVal(1) != 101)
+        cout << "FAIL small: makeEmpty or snapshot of inline pairs." << endl;
+
+    BiMap<string, int, SmallBiMapTraits<string, int, 4>> bm23;
+    for (int i = 0; i < 6; i++)
+        bm23.insert(to_string(i), i);
+    int visited = 0;
+    bm23.forEachPair([&](const string &k, int v) { visited += (k == to_string(v)); });
+    if (visited != 6 || bm23.getKey(5) != "5" || bm23.isSmall())
+        cout << "FAIL small: string keys." << endl;
+
+    // Batch lookups match containsKey/containsVal, in the tables,
+    // inline, and for types without the batch kernel
+    BiMap<int, int> bm24;
+    BiMap<int, int, SmallBiMapTraits<int, int>> bm25;
+    BiMap<int, string> bm26;
+    for (int i = 0; i < 50000; i += 3)
+    {
+        bm24.insert(i, -i);
+        bm26.insert(i, to_string(i));
+    }
+    for (int i = 0; i < 50000; i += 9)
+        bm24.removeKey(i);
+    bm24.insert(INT_MAX, INT_MAX - 1);
+    for (int i = 0; i < 5; i++)
+        bm25.insert(i, 2 * i);
+    int batch[101];
+    bool found[101];
+    bool mismatch = false;
+    for (int start = -50; start < 60000; start += 101)
+    {
+        for (int i = 0; i < 101; i++)
+            batch[i] = start + i;
+        batch[100] = start % 2 ? INT_MAX : INT_MAX - 1;
+        bm24.containsKeys(batch, 101, found);
+        for (int i = 0; i < 101; i++)
+            mismatch |= found[i] != bm24.containsKey(batch[i]);
+        bm24.containsVals(batch, 101, found);
+        for (int i = 0; i < 101; i++)
+            mismatch |= found[i] != bm24.containsVal(batch[i]);
+        bm25.containsVals(batch, 101, found);
+        for (int i = 0; i < 101; i++)
+            mismatch |= found[i] != bm25.containsVal(batch[i]);
+        bm26.containsKeys(batch, 101, found);
+        for (int i = 0; i < 101; i++)
+            mismatch |= found[i] != bm26.containsKey(batch[i]);
+    }
+    if (mismatch)
+        cout << "FAIL containsKeys/containsVals differ from containsKey/containsVal." << endl;
+
+    // Transactions: renumber a block of pairs at once, with one
+    // rehash per table at most, then reject a batch with conflicts
+    BiMap<int, int, TimedTraits> bm27;
+    for (int i = 0; i < 1000; i++)
+        bm27.insert(i, 10000 + i);
+    rehashes = 0;
+    bm27.getInstrumentation().setRehashHook([&](const RehashEvent &) { rehashes++; });
+    BiMap<int, int, TimedTraits>::Transaction tx;
+    for (int i = 0; i < 500; i++)
+    {
+        tx.removeKey(i);
+        tx.insert(i, 10499 - i);
+    }
+    for (int i = 0; i < 3000; i++)
+        tx.insert(5000 + i, 20000 + i);
+    vector<BiMapConflict> conflicts;
+    if (!bm27.apply(tx, conflicts) || !conflicts.empty() || bm27.getSize() != 4000 ||
+        bm27.getVal(0) != 10499 || bm27.getKey(10000) != 499 || bm27.getVal(7999) != 22999 ||
+        rehashes > 2)
+        cout << "FAIL apply: renumbering should apply in one go." << endl;
+
+    tx.clear();
+    tx.insert(1, 1);         // 0: key in map
+    tx.removeKey(-1);        // 1: key not found
+    tx.removeKey(2);         // 2: fine
+    tx.removeVal(10497);     // 3: removes the pair of key 2 again
+    tx.insert(2, 2);         // 4: fine, key 2 is removed
+    tx.insert(3, 2);         // 5: key in map, and value 2 is in the batch
+    tx.insert(9000, 10000);  // 6: value in map
+    if (bm27.apply(tx, conflicts) || conflicts.size() != 6 ||
+        conflicts[0].entry != 0 || conflicts[0].reason != KEY_IN_MAP ||
+        conflicts[1].entry != 1 || conflicts[1].reason != KEY_NOT_FOUND ||
+        conflicts[2].entry != 3 || conflicts[2].reason != VAL_NOT_FOUND ||
+        conflicts[3].entry != 5 || conflicts[3].reason != KEY_IN_MAP ||
+        conflicts[4].entry != 5 || conflicts[4].reason != VAL_IN_BATCH ||
+        conflicts[4].other != 4 || conflicts[5].reason != VAL_IN_MAP)
+        cout << "FAIL apply: wrong conflicts." << endl;
+    if (bm27.getSize() != 4000 || bm27.getVal(2) != 10497 || bm27.containsKey(9000) ||
+        bm27.getInstrumentation().getHistogram(OP_APPLY).getCount() != 2)
+        cout << "FAIL apply: a rejected transaction changed the map." << endl;
+
+    // Transactions inline, out of small mode, and on a bounded map
+    BiMap<int, int, SmallBiMapTraits<int, int>> bm28;
+    BiMap<int, int>::Transaction tx2;
+    for (int i = 0; i < 8; i++)
+        tx2.insert(i, -i);
+    if (!bm28.apply(tx2) || !bm28.isSmall() || bm28.getKey(-7) != 7)
+        cout << "FAIL apply: inline transaction." << endl;
+    tx2.clear();
+    tx2.removeVal(0);
+    tx2.insert(0, 100);
+    tx2.insert(8, -8);
+    if (!bm28.apply(tx2) || bm28.isSmall() || bm28.getSize() != 9 ||
+        bm28.getVal(0) != 100 || bm28.getKey(-8) != 8 || bm28.getKey(-3) != 3)
+        cout << "FAIL apply: transaction out of small mode." << endl;
+    BiMap<int, int> bm29(101, 10);
+    for (int i = 0; i < 8; i++)
+        bm29.insert(i, i);
+    tx2.clear();
+    tx2.removeKey(0);
+    for (int i = 10; i < 14; i++)
+        tx2.insert(i, i);
+    if (bm29.apply(tx2, conflicts) || conflicts.size() != 1 ||
+        conflicts[0].entry != 4 || conflicts[0].reason != MAP_FULL ||
+        bm29.getSize() != 8 || bm29.getEvictions() != 0)
+        cout << "FAIL apply: a bounded map should not overflow." << endl;
+
+    // Making room for a transaction clears DELETED entries, but never
+    // shrinks the tables of a bounded map or below their initial size
+    BiMap<int, int> bm36(101, 1000);
+    for (int i = 0; i < 1900; i++)
+        bm36.insert(i, -i);
+    size_t boundedCapacity = bm36.memoryUsage().capacity;
+    tx2.clear();
+    for (int i = 1700; i < 1900; i++)
+    {
+        tx2.removeKey(i);
+        tx2.insert(i + 10000, i);
+    }
+    if (!bm36.apply(tx2) || bm36.memoryUsage().capacity != boundedCapacity ||
+        bm36.memoryUsage().deletedSlots != 2 * 200 || bm36.getKey(1899) != 11899)
+        cout << "FAIL apply: a bounded map changed its table size." << endl;
+    BiMap<int, int> bm37(100000);
+    for (int i = 0; i < 49000; i++)
+        bm37.insert(i, -i);
+    for (int i = 0; i < 49000; i++)
+        bm37.removeKey(i);
+    size_t initialCapacity = bm37.memoryUsage().capacity;
+    tx2.clear();
+    for (int i = 0; i < 2000; i++)
+        tx2.insert(i, -i);
+    if (!bm37.apply(tx2) || bm37.memoryUsage().capacity != initialCapacity)
+        cout << "FAIL apply: a transaction shrank the tables below their initial size." << endl;
+
     return 0;
 }
\ No newline at end of file
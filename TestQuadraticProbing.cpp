@@ -13,9 +13,22 @@ It verify the correctness of the hash table on insertions,
 deletions and lookups.
 */
 #include <iostream>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+#include <string>
 #include "QuadraticProbing.h"
+#include "MmapAllocator.h"
 using namespace std;
 
+// Traits of a table whose slot array is mapped on huge pages
+template <bool Populate>
+struct HugePageTraits : HashTableTraits<int>
+{
+    template <typename T>
+    using Allocator = MmapAllocator<T, Populate>;
+};
+
 // Simple main
 int main()
 {
@@ -51,5 +64,190 @@ int main()
             cout << "OOPS!!! " << i << endl;
     }
 
+    // Verify the sentinel values are stored in their side slots
+    HashTable<int> h3;
+    if (!h3.insert(INT_MAX) || !h3.insert(INT_MAX - 1) || h3.insert(INT_MAX))
+        cout << "Sentinel insert fails" << endl;
+    h3.remove(INT_MAX);
+    if (h3.contains(INT_MAX) || !h3.contains(INT_MAX - 1))
+        cout << "Sentinel remove fails" << endl;
+
+    // Verify the memory report counts the live elements and tombstones
+    MemoryUsage usage = h2.memoryUsage();
+    if (usage.activeSlots != (NUMS - 1) / 2 || usage.deletedSlots != NUMS / 2)
+        cout << "memoryUsage fails" << endl;
+
+    // Verify the table shrinks after mass removals, but not below its
+    // initial size
+    HashTable<int> h4;
+    for (i = 0; i < 100000; i++)
+        h4.insert(i);
+    for (i = 0; i < 99990; i++)
+        h4.remove(i);
+    if (h4.memoryUsage().capacity > 1000 || !h4.contains(99995))
+        cout << "Shrink fails" << endl;
+    for (; i < 100000; i++)
+        h4.remove(i);
+    if (h4.memoryUsage().capacity != 101)
+        cout << "Shrink below initial size " << h4.memoryUsage().capacity << endl;
+
+    // Verify shrinkToFit and makeEmpty give memory back
+    for (i = 0; i < 1000; i++)
+        h4.insert(i);
+    h4.setShrinkThreshold(0);
+    for (i = 0; i < 990; i++)
+        h4.remove(i);
+    h4.shrinkToFit();
+    if (h4.memoryUsage().capacity != 23 || h4.memoryUsage().deletedSlots != 0 ||
+        !h4.contains(995))
+        cout << "shrinkToFit fails" << endl;
+    for (i = 0; i < 1000; i++)
+        h4.insert(i);
+    h4.makeEmpty();
+    if (h4.memoryUsage().capacity != 101 || h4.contains(5))
+        cout << "makeEmpty fails" << endl;
+    try
+    {
+        h4.setShrinkThreshold(0.5);
+        cout << "setShrinkThreshold fails" << endl;
+    }
+    catch (const IllegalArgumentException &)
+    {
+    }
+
+    // Verify sizes past 2^32 and the overflow checks
+    if (nextPrime((size_t)1 << 32) != 4294967311ULL || nextPrime(65536) != 65537)
+        cout << "nextPrime fails on large sizes" << endl;
+    try
+    {
+        nextPrime(SIZE_MAX - 1);
+        cout << "nextPrime overflow not caught" << endl;
+    }
+    catch (const length_error &)
+    {
+    }
+
+    // Verify a compact table works like the default one, and refuses
+    // to grow past its 32-bit positions
+    HashTable<int, CompactHashTableTraits<int>> h5;
+    for (i = 0; i < NUMS; i++)
+        h5.insert(i * GAP);
+    for (i = 0; i < NUMS; i += 2)
+        h5.remove(i * GAP);
+    for (i = 0; i < NUMS; i++)
+        if (h5.contains(i * GAP) != (i % 2 == 1))
+            cout << "Compact table fails on " << i * GAP << endl;
+    try
+    {
+        HashTable<int, CompactHashTableTraits<int>> h6((size_t)1 << 31);
+        cout << "Compact table capacity overflow not caught" << endl;
+    }
+    catch (const length_error &)
+    {
+    }
+
+    // Verify tables on mapped huge pages, through growth past the
+    // mapping threshold, a shrink back below it, and makeEmpty
+    HashTable<int, HugePageTraits<false>> h7;
+    HashTable<int, HugePageTraits<true>> h8(1000000);
+    for (i = 0; i < 1000000; i++)
+        if (!h7.insert(i) || !h8.insert(i))
+            cout << "Huge page insert fails on " << i << endl;
+    for (i = 0; i < 1000000; i += 3)
+        if (!h7.remove(i) || !h8.remove(i))
+            cout << "Huge page remove fails on " << i << endl;
+    for (i = 0; i < 1000000; i++)
+        if (h7.contains(i) != (i % 3 != 0) || h8.contains(i) != (i % 3 != 0))
+            cout << "Huge page contains fails on " << i << endl;
+    for (i = 0; i < 1000000; i++)
+        h7.remove(i);
+    if (h7.memoryUsage().capacity != 101)
+        cout << "Huge page shrink fails" << endl;
+    h8.makeEmpty();
+    if (h8.contains(1) || h8.memoryUsage().activeSlots != 0)
+        cout << "Huge page makeEmpty fails" << endl;
+
+    // Verify containsBatch against contains, with collisions, DELETED
+    // slots, negative objs, sentinels and a batch that is not a
+    // multiple of 8
+    HashTable<int> h9(7);
+    HashTable<int, CompactHashTableTraits<int>> h10;
+    for (i = -500; i < 20000; i += 3)
+    {
+        h9.insert(i * 7);
+        h10.insert(i * 7);
+    }
+    for (i = 0; i < 20000; i += 4)
+    {
+        h9.remove(i * 7);
+        h10.remove(i * 7);
+    }
+    h9.insert(INT_MAX);
+    h10.insert(INT_MAX - 1);
+    vector<int> batch;
+    for (i = -4000; i < 150000; i++)
+        batch.push_back(i);
+    batch.push_back(INT_MAX);
+    batch.push_back(INT_MAX - 1);
+    batch.push_back(INT_MIN);
+    bool *found = new bool[batch.size()];
+    h9.containsBatch(batch.data(), batch.size(), found);
+    for (size_t j = 0; j < batch.size(); j++)
+        if (found[j] != h9.contains(batch[j]))
+            cout << "containsBatch fails on " << batch[j] << endl;
+    h10.containsBatch(batch.data(), batch.size(), found);
+    for (size_t j = 0; j < batch.size(); j++)
+        if (found[j] != h10.contains(batch[j]))
+            cout << "Compact containsBatch fails on " << batch[j] << endl;
+    delete[] found;
+
+    // Verify the set operations against contains, on 4 threads and
+    // on 1, with sentinel objs, and with a smaller left or right side
+    HashTable<int> evens, triples;
+    for (i = -100000; i < 400000; i += 2)
+        evens.insert(i);
+    for (i = 0; i < 900000; i += 3)
+        triples.insert(i);
+    evens.insert(INT_MAX);
+    evens.insert(INT_MAX - 1);
+    triples.insert(INT_MAX);
+    for (unsigned threads : {4u, 1u})
+    {
+        HashTable<int> both = evens.intersect(triples, threads);
+        HashTable<int> either = evens.unite(triples, threads);
+        HashTable<int> onlyEvens = evens.subtract(triples, threads);
+        HashTable<int> onlyTriples = triples.subtract(evens, threads);
+        size_t inBoth = 0, inEither = 0;
+        for (i = -100000; i < 900000; i++)
+        {
+            bool e = evens.contains(i), t = triples.contains(i);
+            inBoth += e && t;
+            inEither += e || t;
+            if (both.contains(i) != (e && t) || either.contains(i) != (e || t) ||
+                onlyEvens.contains(i) != (e && !t) || onlyTriples.contains(i) != (t && !e))
+                cout << "Set operation fails on " << i << " with " << threads << " threads" << endl;
+        }
+        if (both.getSize() != inBoth + 1 || either.getSize() != inEither + 2 ||
+            onlyEvens.getSize() != evens.getSize() - inBoth - 1 ||
+            !both.contains(INT_MAX) || both.contains(INT_MAX - 1) ||
+            !either.contains(INT_MAX - 1) || !onlyEvens.contains(INT_MAX - 1))
+            cout << "Set operation sizes or sentinels fail with " << threads << " threads" << endl;
+        if (!both.isSubset(evens, threads) || !both.isSubset(triples, threads) ||
+            evens.isSubset(triples, threads) || !triples.isSubset(either, threads) ||
+            onlyEvens.isSubset(triples, threads))
+            cout << "isSubset fails with " << threads << " threads" << endl;
+    }
+
+    HashTable<string> s1, s2;
+    for (i = 0; i < 100; i++)
+    {
+        s1.insert(to_string(i));
+        s2.insert(to_string(2 * i));
+    }
+    if (s1.intersect(s2).getSize() != 50 || s1.unite(s2).getSize() != 150 ||
+        !s1.subtract(s2).contains("99") || s1.subtract(s2).contains("98") ||
+        !s1.intersect(s2).isSubset(s2))
+        cout << "String set operations fail" << endl;
+
     return 0;
 }